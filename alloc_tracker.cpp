@@ -0,0 +1,114 @@
+#include "alloc_tracker.h"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+
+// Counts of the calling thread and of the whole process
+static thread_local AllocStats thread_stats = { 0, 0, 0 };
+static std::atomic<uint64_t> total_allocations{0};
+static std::atomic<uint64_t> total_frees{0};
+static std::atomic<uint64_t> total_bytes{0};
+
+
+#ifdef ALLOC_TRACKING
+
+//==========================================
+// Counts an allocation, then allocates like the default operators
+static void *tracked_alloc(size_t size, size_t alignment)
+{
+  thread_stats.allocations++;
+  thread_stats.bytes += size;
+  total_allocations.fetch_add(1, std::memory_order_relaxed);
+  total_bytes.fetch_add(size, std::memory_order_relaxed);
+
+  if(size == 0) size = 1;
+  if(alignment <= alignof(std::max_align_t)) return malloc(size);
+
+  void *p = nullptr;
+  return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+static void tracked_free(void *p)
+{
+  if(p == nullptr) return;
+  thread_stats.frees++;
+  total_frees.fetch_add(1, std::memory_order_relaxed);
+  free(p);
+}
+
+
+// Replaced global operators===========
+void *operator new(size_t size)
+{
+  void *p = tracked_alloc(size, 0);
+  if(p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t size)
+{
+  void *p = tracked_alloc(size, 0);
+  if(p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+  void *p = tracked_alloc(size, (size_t)alignment);
+  if(p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+  void *p = tracked_alloc(size, (size_t)alignment);
+  if(p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  return tracked_alloc(size, 0);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+  return tracked_alloc(size, 0);
+}
+
+void operator delete(void *p) noexcept { tracked_free(p); }
+void operator delete[](void *p) noexcept { tracked_free(p); }
+void operator delete(void *p, size_t) noexcept { tracked_free(p); }
+void operator delete[](void *p, size_t) noexcept { tracked_free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { tracked_free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { tracked_free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { tracked_free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { tracked_free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { tracked_free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { tracked_free(p); }
+
+#endif
+
+
+// Getters===========
+bool AllocTracker::is_enabled()
+{
+#ifdef ALLOC_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AllocTracker::get_thread(AllocStats &stats)
+{
+  stats = thread_stats;
+}
+
+void AllocTracker::get_total(AllocStats &stats)
+{
+  stats.allocations = total_allocations.load(std::memory_order_relaxed);
+  stats.frees = total_frees.load(std::memory_order_relaxed);
+  stats.bytes = total_bytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,26 @@
+#ifndef alloc_tracker_h
+#define alloc_tracker_h
+
+#include <cstdint>
+
+/// @brief Heap activity through operator new/delete
+struct AllocStats {
+  uint64_t allocations;
+  uint64_t frees;
+  uint64_t bytes;  // requested by the allocations
+};
+
+/// @brief Counts of the replaced global operator new/delete.
+/// The operators are only replaced in profiling builds (ALLOC_TRACKING defined, `make profile`);
+/// otherwise every count stays 0 and is_enabled() is false.
+/// Counts are kept per thread (for attribution to the code running on it) and in total
+class AllocTracker {
+
+  public:
+    // getters
+    static bool is_enabled();
+    static void get_thread(AllocStats &stats);
+    static void get_total(AllocStats &stats);
+};
+
+#endif
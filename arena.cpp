@@ -1,5 +1,7 @@
 #include "arena.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 
 /// @brief Initialize arena attributes
@@ -24,6 +26,298 @@ void Arena::setup(const std::vector<svg_tools::Rect> &rectangles) {
 
   // Removing arena from obstacles
   Arena::obstacles.erase(Arena::obstacles.begin() + index_of_arena);
+  Arena::pieces.clear();
+
+  // Spatial index for collision queries
+  Arena::build_index();
+}
+
+
+/// @brief Initialize arena attributes from known bounds (obstacles are taken over)
+/// @param x 
+/// @param y 
+/// @param width 
+/// @param height 
+/// @param obstacles 
+void Arena::setup(double x, double y, double width, double height, std::vector<svg_tools::Rect> obstacles)
+{
+  Arena::x = x;
+  Arena::y = y;
+  Arena::width = width;
+  Arena::height = height;
+  Arena::obstacles = std::move(obstacles);
+  Arena::pieces.clear();
+  Arena::build_index();
+}
+
+
+/// @brief Initialize arena attributes from pieces already indexed on their own
+/// (with this arena's index). Obstacles are copied in piece order and the pieces'
+/// indices are reused, so only pieces that were never seen cost an index build
+/// @param x 
+/// @param y 
+/// @param width 
+/// @param height 
+/// @param pieces 
+void Arena::assemble(double x, double y, double width, double height, const std::vector<const Arena *> &pieces)
+{
+  Arena::x = x;
+  Arena::y = y;
+  Arena::width = width;
+  Arena::height = height;
+  Arena::obstacles.clear();
+  Arena::obstacles_grid = Grid();
+  Arena::obstacles_bvh = Bvh();
+  Arena::pieces.clear();
+
+  for(const Arena *piece: pieces) {
+    if(piece->obstacles.empty()) continue;
+
+    Piece p = { Arena::obstacles.size(), piece->obstacles.size(), piece->obstacles[0].x, piece->obstacles[0].x, piece->obstacles_grid, piece->obstacles_bvh };
+    for(const svg_tools::Rect &r: piece->obstacles) {
+      p.left = std::min(p.left, r.x);
+      p.right = std::max(p.right, r.x + r.width);
+    }
+    Arena::obstacles.insert(Arena::obstacles.end(), piece->obstacles.begin(), piece->obstacles.end());
+    Arena::pieces.push_back(std::move(p));
+  }
+}
+
+
+/// @brief Selects the spatial index (rebuilt if the arena is already set up)
+/// @param index 
+void Arena::set_index(ObstacleIndex index)
+{
+  Arena::index = index;
+  Arena::build_index();
+}
+
+
+//======================================
+// Builds only the selected spatial index (of every piece, for assembled arenas)
+void Arena::build_index()
+{
+  Arena::obstacles_grid = Grid();
+  Arena::obstacles_bvh = Bvh();
+
+  if(Arena::pieces.empty()) {
+    if(Arena::index == ObstacleIndex::UniformGrid) {
+      Arena::obstacles_grid.build(Arena::obstacles);
+    }
+    else if(Arena::index == ObstacleIndex::BoundingVolumeHierarchy) {
+      Arena::obstacles_bvh.build(Arena::obstacles);
+    }
+    return;
+  }
+
+  for(Piece &piece: Arena::pieces) {
+    std::vector<svg_tools::Rect> rects(Arena::obstacles.begin() + piece.first, Arena::obstacles.begin() + piece.first + piece.count);
+    piece.grid = Grid();
+    piece.bvh = Bvh();
+    if(Arena::index == ObstacleIndex::UniformGrid) piece.grid.build(rects);
+    else if(Arena::index == ObstacleIndex::BoundingVolumeHierarchy) piece.bvh.build(rects);
+  }
+}
+
+
+/// @brief Writes the bounds, the obstacles and both spatial indices prebuilt.
+/// Each index is a length-prefixed section so a reader can skip the one it does not use
+/// @param snapshot
+void Arena::save(Snapshot &snapshot) const
+{
+  snapshot.put(Arena::x);
+  snapshot.put(Arena::y);
+  snapshot.put(Arena::width);
+  snapshot.put(Arena::height);
+
+  // Obstacles as packed (x, y, width, height)
+  std::vector<double> bounds;
+  bounds.reserve(4 * Arena::obstacles.size());
+  for(const svg_tools::Rect &r: Arena::obstacles) {
+    bounds.insert(bounds.end(), { r.x, r.y, r.width, r.height });
+  }
+  snapshot.align_write(8);
+  snapshot.put_vector(bounds, bounds.size());
+
+  Grid grid;
+  Bvh bvh;
+  Snapshot grid_section, bvh_section;
+  grid.build(Arena::obstacles);
+  grid.save(grid_section);
+  bvh.build(Arena::obstacles);
+  bvh.save(bvh_section);
+
+  for(const Snapshot *section: { &grid_section, &bvh_section }) {
+    snapshot.align_write(8);
+    snapshot.put(section->size());
+    snapshot.write(section->data(), section->size());
+  }
+}
+
+
+/// @brief Reads an arena written by save(), loading only the selected index.
+/// Each index is read within its own section and checked against the obstacles
+/// @param snapshot
+/// @return false if the arena is truncated or an index does not match it
+bool Arena::restore(Snapshot &snapshot)
+{
+  snapshot.get(Arena::x);
+  snapshot.get(Arena::y);
+  snapshot.get(Arena::width);
+  snapshot.get(Arena::height);
+
+  std::vector<double> bounds;
+  snapshot.align_read(8);
+  snapshot.get_vector(bounds);
+  Arena::obstacles.resize(bounds.size() / 4);
+  for(size_t i = 0; i < Arena::obstacles.size(); i++) {
+    const double *b = &bounds[4 * i];
+    Arena::obstacles[i] = { b[0], b[1], b[2], b[3], "black" };
+  }
+
+  Arena::obstacles_grid = Grid();
+  Arena::obstacles_bvh = Bvh();
+  Arena::pieces.clear();
+  bool ok = bounds.size() % 4 == 0 && !snapshot.is_overrun() &&
+            std::isfinite(Arena::x) && std::isfinite(Arena::y) && std::isfinite(Arena::width) && std::isfinite(Arena::height);
+  for(size_t k = 0; ok && k < bounds.size(); k++) {
+    ok = std::isfinite(bounds[k]);
+  }
+
+  for(ObstacleIndex section_index: { ObstacleIndex::UniformGrid, ObstacleIndex::BoundingVolumeHierarchy }) {
+    size_t bytes = 0;
+    snapshot.align_read(8);
+    snapshot.get(bytes);
+    if(bytes > snapshot.remaining()) return false;
+
+    // The index must fill its section exactly
+    if(Arena::index == section_index) {
+      Snapshot section;
+      section.attach(snapshot.data() + snapshot.size() - snapshot.remaining(), bytes);
+      ok = ok && (
+        (section_index == ObstacleIndex::UniformGrid)
+          ? Arena::obstacles_grid.restore(section, Arena::obstacles.size())
+          : Arena::obstacles_bvh.restore(section, Arena::obstacles.size())
+      );
+      ok = ok && section.remaining() == 0;
+    }
+    snapshot.skip(bytes);
+  }
+
+  return ok && !snapshot.is_overrun();
+}
+
+
+/// @brief Appends to out the indices of obstacles that may overlap the region
+/// @param left 
+/// @param top 
+/// @param right 
+/// @param bottom 
+/// @param out 
+void Arena::query_obstacles(double left, double top, double right, double bottom, std::vector<int> &out) const
+{
+  if(!Arena::pieces.empty()) {
+    for(const Piece &piece: Arena::pieces) {
+      if(piece.left <= right && piece.right >= left) {
+        Arena::query_piece(piece, left, top, right, bottom, out);
+      }
+    }
+    return;
+  }
+
+  switch(Arena::index) {
+    case ObstacleIndex::UniformGrid:
+      Arena::obstacles_grid.query(left, top, right, bottom, out);
+      break;
+
+    case ObstacleIndex::BoundingVolumeHierarchy:
+      Arena::obstacles_bvh.query(left, top, right, bottom, out);
+      break;
+
+    default:  // every obstacle is a candidate
+      for(size_t i = 0; i < Arena::obstacles.size(); i++) {
+        out.push_back(i);
+      }
+      break;
+  }
+}
+
+
+//======================================
+// Appends the candidates of a piece (its index numbers them from the piece's first obstacle)
+void Arena::query_piece(const Piece &piece, double left, double top, double right, double bottom, std::vector<int> &out) const
+{
+  size_t start = out.size();
+
+  switch(Arena::index) {
+    case ObstacleIndex::UniformGrid:
+      piece.grid.query(left, top, right, bottom, out);
+      break;
+
+    case ObstacleIndex::BoundingVolumeHierarchy:
+      piece.bvh.query(left, top, right, bottom, out);
+      break;
+
+    default:
+      for(size_t i = 0; i < piece.count; i++) {
+        out.push_back(i);
+      }
+      break;
+  }
+
+  for(size_t k = start; k < out.size(); k++) {
+    out[k] += piece.first;
+  }
+}
+
+
+/// @brief Finds the first obstacle hit by the segment (x0,y0)->(x1,y1)
+/// @param hit index of the obstacle
+/// @param t segment parameter in [0, 1] of the entry point
+/// @return true if any obstacle is hit
+bool Arena::raycast_obstacles(double x0, double y0, double x1, double y1, int &hit, double &t) const
+{
+  if(Arena::index == ObstacleIndex::BoundingVolumeHierarchy && Arena::pieces.empty()) {
+    return Arena::obstacles_bvh.raycast(x0, y0, x1, y1, hit, t);
+  }
+
+  // Closest hit among the pieces the segment crosses
+  if(Arena::index == ObstacleIndex::BoundingVolumeHierarchy) {
+    bool found = false;
+    for(const Piece &piece: Arena::pieces) {
+      int piece_hit;
+      double t_hit;
+      if(piece.left > std::max(x0, x1) || piece.right < std::min(x0, x1)) continue;
+      if(piece.bvh.raycast(x0, y0, x1, y1, piece_hit, t_hit) && (!found || t_hit < t)) {
+        hit = piece.first + piece_hit;
+        t = t_hit;
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  // Testing candidates around the segment
+  static thread_local std::vector<int> candidates;
+  candidates.clear();
+  Arena::query_obstacles(std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1), candidates);
+
+  bool found = false;
+  double best = 1.0;
+  for(int i: candidates) {
+    const svg_tools::Rect &r = Arena::obstacles[i];
+    double t_hit;
+    if(geometry_tools::segment_hits_box(x0, y0, x1 - x0, y1 - y0, r.x, r.y, r.x + r.width, r.y + r.height, best, t_hit)) {
+      if(!found || t_hit < best) {
+        best = t_hit;
+        hit = i;
+        found = true;
+      }
+    }
+  }
+
+  if(found) t = best;
+  return found;
 }
 
 
@@ -83,27 +377,37 @@ std::map<std::string, double> Arena::get_2dprojection_limits() const
 
 
 // Getters===========
-double Arena::get_x()
+double Arena::get_x() const
 {
   return Arena::x;
 }
 
-double Arena::get_y()
+double Arena::get_y() const
 {
   return Arena::y;
 }
 
-double Arena::get_width()
+double Arena::get_width() const
 {
   return Arena::width;
 }
 
-double Arena::get_height()
+double Arena::get_height() const
 {
   return Arena::height;
 }
 
-std::vector<svg_tools::Rect> Arena::get_obstacles()
+ObstacleIndex Arena::get_index() const
+{
+  return Arena::index;
+}
+
+const std::vector<svg_tools::Rect> &Arena::get_obstacles() const
 {
   return Arena::obstacles;
 }
+
+const svg_tools::Rect &Arena::get_obstacle(int index) const
+{
+  return Arena::obstacles[index];
+}
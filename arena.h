@@ -6,9 +6,19 @@
 #include <string>
 #include <vector>
 #include "utils.h"
+#include "grid.h"
+#include "bvh.h"
+#include "snapshot.h"
 #include <array>
 #include <map>
 
+// Spatial index used by obstacle queries
+enum ObstacleIndex {
+  BruteForce,
+  UniformGrid,
+  BoundingVolumeHierarchy
+};
+
 /// @brief Class to create the game environment
 class Arena {
   
@@ -18,6 +28,23 @@ class Arena {
   double width = 0;
   double height = 0;
   std::vector<svg_tools::Rect> obstacles = {};
+  ObstacleIndex index = ObstacleIndex::UniformGrid;
+  Grid obstacles_grid;
+  Bvh obstacles_bvh;
+
+  // Arenas assembled from pieces (e.g. streamed level chunks) keep each piece's index
+  struct Piece {
+    size_t first;   // first obstacle of the piece
+    size_t count;
+    double left;    // x range of its obstacles
+    double right;
+    Grid grid;
+    Bvh bvh;
+  };
+  std::vector<Piece> pieces = {};
+
+  void build_index();
+  void query_piece(const Piece &piece, double left, double top, double right, double bottom, std::vector<int> &out) const;
 
   void draw_rect(
     const double x,
@@ -31,13 +58,22 @@ class Arena {
     Arena(){}
     void draw() const;
     void setup(const std::vector<svg_tools::Rect> &rectangles);
+    void setup(double x, double y, double width, double height, std::vector<svg_tools::Rect> obstacles);
+    void assemble(double x, double y, double width, double height, const std::vector<const Arena *> &pieces);
+    void query_obstacles(double left, double top, double right, double bottom, std::vector<int> &out) const;
+    bool raycast_obstacles(double x0, double y0, double x1, double y1, int &hit, double &t) const;
+    void set_index(ObstacleIndex index);
+    void save(Snapshot &snapshot) const;
+    bool restore(Snapshot &snapshot);
     
     // getters
-    double get_x();
-    double get_y();
-    double get_width();
-    double get_height();
-    std::vector<svg_tools::Rect> get_obstacles();
+    double get_x() const;
+    double get_y() const;
+    double get_width() const;
+    double get_height() const;
+    ObstacleIndex get_index() const;
+    const std::vector<svg_tools::Rect> &get_obstacles() const;
+    const svg_tools::Rect &get_obstacle(int index) const;
     std::map<std::string, double> get_2dprojection_limits() const;
 };
 
@@ -0,0 +1,223 @@
+#include "../collision.h"
+#include "../arena.h"
+#include "../player.h"
+#include "../rng.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <functional>
+
+// Scenes (in the units of assets/arena.svg)
+#define BENCH_HEIGHT      91.659218
+#define BENCH_RADIUS      4.7036037
+#define BENCH_DENSITY     5       // obstacles per 100 units of width, like the shipped arena
+#define BENCH_PROBES      1024    // distinct query players
+#define BENCH_STEP        (1000.0 / 120)
+
+// Timing
+#define BENCH_MIN_TIME    0.02    // seconds per run
+#define BENCH_RUNS        3       // best run is reported
+#define BENCH_BRUTE_LIMIT 10000   // brute force is skipped above this many obstacles
+
+/// @brief Generated arena with enemies and the players used as query probes
+struct Scene {
+  Arena arena;
+  std::vector<Player> enemies;
+  std::vector<Player> probes;
+  CollisionWorld world;
+};
+
+
+//==========================================
+// Player standing with its bottom at y
+static Player standing_player(double cx, double bottom)
+{
+  Player p;
+  p.setup({ cx, bottom - BENCH_RADIUS, BENCH_RADIUS, "red" });
+  return p;
+}
+
+
+//==========================================
+// Platforms and floor blocks spread over a width proportional to the obstacles;
+// enemies and probes stand on the floor or on platforms, facing either way
+static void build_scene(Scene &scene, long obstacles, long enemies, ObstacleIndex index, uint64_t seed)
+{
+  Rng rng;
+  rng.set_seed(seed);
+  RngStream obstacle_rng(rng, 0), player_rng(rng, 1);
+
+  double width = std::max(100.0 * obstacles / BENCH_DENSITY, 400.0);
+  std::vector<svg_tools::Rect> rects;
+  rects.reserve(obstacles);
+  for(long i = 0; i < obstacles; i++) {
+    if(obstacle_rng.next_uniform(0, 1) < 0.2) {
+      rects.push_back({ obstacle_rng.next_uniform(0, width - 6), BENCH_HEIGHT - 6, 6, 6, "black" });
+    } else {
+      double w = obstacle_rng.next_uniform(10, 32);
+      double y = obstacle_rng.next_uniform(2 * BENCH_RADIUS, BENCH_HEIGHT - 3 * BENCH_RADIUS);
+      rects.push_back({ obstacle_rng.next_uniform(0, width - w), y, w, 3.0238097, "black" });
+    }
+  }
+
+  auto place = [&](std::vector<Player> &players, long count) {
+    players.clear();
+    players.reserve(count);
+    for(long i = 0; i < count; i++) {
+      Player p;
+      if(rects.empty() || player_rng.next_uniform(0, 1) < 0.5) {
+        p = standing_player(player_rng.next_uniform(BENCH_RADIUS, width - BENCH_RADIUS), BENCH_HEIGHT);
+      } else {
+        const svg_tools::Rect &r = rects[player_rng.next_below(rects.size())];
+        p = standing_player(r.x + player_rng.next_uniform(0, r.width), r.y);
+      }
+      if(player_rng.next_below(2)) p.revert_walk_direction();
+      players.push_back(p);
+    }
+  };
+
+  scene.arena = Arena();
+  scene.arena.set_index(index);
+  scene.arena.setup(0, 0, width, BENCH_HEIGHT, std::move(rects));
+  place(scene.enemies, enemies);
+  place(scene.probes, BENCH_PROBES);
+  scene.world.setup(scene.arena, scene.enemies);
+}
+
+
+//==========================================
+// Best time of a query over the probes (ns per query)
+static double measure(const Scene &scene, size_t queries_per_probe, const std::function<double(const Player &)> &query)
+{
+  volatile double sink = 0;
+  double best = 0;
+
+  for(int run = 0; run < BENCH_RUNS; run++) {
+    size_t queries = 0;
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+
+    while(elapsed < BENCH_MIN_TIME) {
+      for(const Player &probe: scene.probes) {
+        sum += query(probe);
+      }
+      queries += scene.probes.size() * queries_per_probe;
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    sink = sink + sum;
+    double ns = elapsed * 1e9 / queries;
+    if(run == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+
+//==========================================
+// One row per query of a scene, with the growth exponent against the previous scene
+// of the series (time ~ size^exponent: 0 is flat, 1 is linear)
+struct Row {
+  std::string query;
+  double ns;
+};
+
+static void report(
+  const Scene &scene, const char *index_name, long obstacles, long enemies,
+  double size, double previous_size, std::vector<Row> &previous)
+{
+  double reach = scene.probes[0].get_vertical_reach(BENCH_STEP, 28);
+  double walk = BENCH_STEP * 0.05;
+  const CollisionWorld &world = scene.world;
+  const std::vector<Player> &all_enemies = scene.enemies;
+
+  std::vector<Row> rows = {
+    { "walk sweep", measure(scene, 1, [&](const Player &p) {
+        return world.sweep(p, (p.get_walk_direction() == HorizontalMoveDirection::Left) ? -walk : walk, 0);
+      }) },
+    { "jump sweep", measure(scene, 1, [&](const Player &p) { return world.sweep(p, 0, -reach); }) },
+    { "fall sweep", measure(scene, 1, [&](const Player &p) { return world.sweep(p, 0, reach); }) },
+    { "platform end", measure(scene, 1, [&](const Player &p) { return (double)world.platform_end_detected(p); }) },
+  };
+  if(!all_enemies.empty()) {
+    rows.push_back({ "players pair", measure(scene, all_enemies.size(), [&](const Player &p) {
+      double hits = 0;
+      for(const Player &enemy: all_enemies) hits += CollisionWorld::players_collision(p, enemy);
+      return hits;
+    }) });
+  }
+
+  for(size_t i = 0; i < rows.size(); i++) {
+    std::cout << std::left << std::setw(14) << rows[i].query << std::setw(7) << index_name;
+    std::cout << std::right << std::setw(10) << obstacles << std::setw(9) << enemies;
+    std::cout << std::fixed << std::setprecision(1) << std::setw(12) << rows[i].ns;
+    if(previous.size() == rows.size() && previous_size > 0) {
+      double exponent = std::log(rows[i].ns / previous[i].ns) / std::log(size / previous_size);
+      std::cout << std::setprecision(2) << std::setw(10) << exponent;
+    }
+    std::cout << std::defaultfloat << std::endl;
+  }
+  previous = rows;
+}
+
+
+//=============================//
+// Collision benchmark         //
+//=============================//
+// Times the collision queries of the game over generated scenes:
+//   obstacles series (100 enemies) for every spatial index, then
+//   enemies series (10k obstacles, grid)
+// --quick stops at 100k obstacles and 1000 enemies
+int main(int argc, char *argv[])
+{
+  bool quick = false;
+  uint64_t seed = 1;
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "--quick")) quick = true;
+    else if(!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--quick] [--seed S]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<long> obstacle_counts = { 1000, 10000, 100000, 1000000 };
+  std::vector<long> enemy_counts = { 10, 100, 1000, 10000 };
+  if(quick) {
+    obstacle_counts.pop_back();
+    enemy_counts.pop_back();
+  }
+
+  const char *index_names[] = { "brute", "grid", "bvh" };
+  Scene scene;
+
+  std::cout << "query         index  obstacles  enemies    ns/query  exponent" << std::endl;
+
+  // Obstacles series=======================
+  for(ObstacleIndex index: { ObstacleIndex::BruteForce, ObstacleIndex::UniformGrid, ObstacleIndex::BoundingVolumeHierarchy }) {
+    std::vector<Row> previous;
+    long previous_count = 0;
+
+    for(long obstacles: obstacle_counts) {
+      if(index == ObstacleIndex::BruteForce && obstacles > BENCH_BRUTE_LIMIT) break;
+      build_scene(scene, obstacles, 100, index, seed);
+      report(scene, index_names[index], obstacles, 100, obstacles, previous_count, previous);
+      previous_count = obstacles;
+    }
+    std::cout << std::endl;
+  }
+
+  // Enemies series=========================
+  std::vector<Row> previous;
+  long previous_count = 0;
+  for(long enemies: enemy_counts) {
+    build_scene(scene, 10000, enemies, ObstacleIndex::UniformGrid, seed);
+    report(scene, "grid", 10000, enemies, enemies, previous_count, previous);
+    previous_count = enemies;
+  }
+  return 0;
+}
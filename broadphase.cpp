@@ -0,0 +1,281 @@
+#include "broadphase.h"
+#include <algorithm>
+
+// Endpoint shifts per endpoint allowed before falling back to a full sort
+#define SAP_SHIFT_BUDGET 2
+
+
+/// @brief Registers a new box. It takes part in the sweep after the next update()
+/// @return proxy id
+int SweepAndPrune::create_proxy(ProxyKind kind, int user, double min_x, double max_x, double min_y, double max_y)
+{
+  int proxy;
+  Proxy p = { min_x, max_x, min_y, max_y, kind, user, true };
+
+  // Reusing ids of destroyed proxies
+  if(!SweepAndPrune::free_proxies.empty()) {
+    proxy = SweepAndPrune::free_proxies.back();
+    SweepAndPrune::free_proxies.pop_back();
+    SweepAndPrune::proxies[proxy] = p;
+  } else {
+    proxy = SweepAndPrune::proxies.size();
+    SweepAndPrune::proxies.push_back(p);
+    SweepAndPrune::active_slot.push_back(-1);
+  }
+
+  SweepAndPrune::new_endpoints.push_back({ min_x, proxy, true });
+  SweepAndPrune::new_endpoints.push_back({ max_x, proxy, false });
+  return proxy;
+}
+
+
+/// @brief Updates the box and the caller's index of a proxy
+void SweepAndPrune::move_proxy(int proxy, int user, double min_x, double max_x, double min_y, double max_y)
+{
+  Proxy &p = SweepAndPrune::proxies[proxy];
+  p.min_x = min_x;
+  p.max_x = max_x;
+  p.min_y = min_y;
+  p.max_y = max_y;
+  p.user = user;
+}
+
+
+/// @brief Removes a proxy (its endpoints are dropped on the next update)
+void SweepAndPrune::destroy_proxy(int proxy)
+{
+  SweepAndPrune::proxies[proxy].alive = false;
+  SweepAndPrune::has_destroyed = true;
+}
+
+
+//=======================================================
+// Min endpoints come first on ties (touching boxes overlap)
+bool SweepAndPrune::endpoint_less(const Endpoint &e1, const Endpoint &e2)
+{
+  return e1.value < e2.value || (e1.value == e2.value && e1.is_min && !e2.is_min);
+}
+
+
+/// @brief Refreshes endpoint values and restores the order
+void SweepAndPrune::update()
+{
+  std::vector<Endpoint> &list = SweepAndPrune::endpoints;
+
+  // Dropping destroyed proxies (ids are released only now, once their endpoints are gone)
+  if(SweepAndPrune::has_destroyed) {
+    size_t kept = 0;
+    for(size_t i = 0; i < list.size(); i++) {
+      if(SweepAndPrune::proxies[list[i].proxy].alive) {
+        list[kept++] = list[i];
+      } else if(list[i].is_min) {
+        SweepAndPrune::free_proxies.push_back(list[i].proxy);
+      }
+    }
+    list.resize(kept);
+
+    // Created and destroyed before being merged
+    size_t kept_new = 0;
+    for(size_t i = 0; i < SweepAndPrune::new_endpoints.size(); i++) {
+      const Endpoint &e = SweepAndPrune::new_endpoints[i];
+      if(SweepAndPrune::proxies[e.proxy].alive) {
+        SweepAndPrune::new_endpoints[kept_new++] = e;
+      } else if(e.is_min) {
+        SweepAndPrune::free_proxies.push_back(e.proxy);
+      }
+    }
+    SweepAndPrune::new_endpoints.resize(kept_new);
+    SweepAndPrune::has_destroyed = false;
+  }
+
+  // Current values
+  for(Endpoint &e: list) {
+    const Proxy &p = SweepAndPrune::proxies[e.proxy];
+    e.value = e.is_min ? p.min_x : p.max_x;
+  }
+
+  // Lambda instead of a function pointer so the sorts can inline the comparison
+  auto less = [](const Endpoint &e1, const Endpoint &e2) { return endpoint_less(e1, e2); };
+
+  // Insertion sort: objects move little between ticks, so the list is nearly sorted.
+  // Crowded scenes may move too many endpoints past each other: then a full sort is cheaper
+  size_t budget = SAP_SHIFT_BUDGET * list.size();
+  size_t shifts = 0;
+
+  for(size_t i = 1; i < list.size(); i++) {
+    Endpoint e = list[i];
+    size_t j = i;
+    while(j > 0 && endpoint_less(e, list[j - 1])) {
+      list[j] = list[j - 1];
+      j--;
+    }
+    list[j] = e;
+
+    shifts += i - j;
+    if(shifts > budget) {
+      std::sort(list.begin(), list.end(), less);
+      break;
+    }
+  }
+
+  // Merging the newly created proxies
+  if(!SweepAndPrune::new_endpoints.empty()) {
+    for(Endpoint &e: SweepAndPrune::new_endpoints) {
+      const Proxy &p = SweepAndPrune::proxies[e.proxy];
+      e.value = e.is_min ? p.min_x : p.max_x;
+    }
+    std::sort(SweepAndPrune::new_endpoints.begin(), SweepAndPrune::new_endpoints.end(), less);
+
+    // Merged backwards in place (std::inplace_merge would allocate a buffer),
+    // old endpoints first on ties
+    const std::vector<Endpoint> &added = SweepAndPrune::new_endpoints;
+    size_t i = list.size();
+    size_t j = added.size();
+    list.resize(list.size() + added.size());
+    for(size_t k = list.size(); j > 0;) {
+      if(i > 0 && endpoint_less(added[j - 1], list[i - 1])) {
+        list[--k] = list[--i];
+      } else {
+        list[--k] = added[--j];
+      }
+    }
+    SweepAndPrune::new_endpoints.clear();
+  }
+
+  // Left edges in order, for query()
+  SweepAndPrune::sorted_min_x.clear();
+  SweepAndPrune::sorted_proxies.clear();
+  SweepAndPrune::max_width = 0;
+  for(const Endpoint &e: list) {
+    if(!e.is_min) continue;
+    const Proxy &p = SweepAndPrune::proxies[e.proxy];
+    SweepAndPrune::sorted_min_x.push_back(p.min_x);
+    SweepAndPrune::sorted_proxies.push_back(e.proxy);
+    SweepAndPrune::max_width = std::max(SweepAndPrune::max_width, p.max_x - p.min_x);
+  }
+}
+
+
+/// @brief Sweeps the sorted endpoints and appends the overlapping pairs of different kinds
+/// @param out 
+void SweepAndPrune::find_pairs(std::vector<ProxyPair> &out)
+{
+  SweepAndPrune::active_players.clear();
+
+  for(const Endpoint &e: SweepAndPrune::endpoints) {
+    const Proxy &p = SweepAndPrune::proxies[e.proxy];
+
+    if(!e.is_min) {
+      deactivate(SweepAndPrune::active_players, e.proxy);
+      continue;
+    }
+
+    for(int other: SweepAndPrune::active_players) {
+      if(SweepAndPrune::proxies[other].kind != p.kind && overlap_y(other, e.proxy)) {
+        out.push_back({ other, e.proxy });
+      }
+    }
+
+    activate(SweepAndPrune::active_players, e.proxy);
+  }
+}
+
+
+/// @brief Appends the proxies whose box overlaps the given one (closed intervals),
+/// in order of left edge. Boxes are the ones of the last update()
+/// @param min_x
+/// @param max_x
+/// @param min_y
+/// @param max_y
+/// @param out
+void SweepAndPrune::query(double min_x, double max_x, double min_y, double max_y, std::vector<int> &out) const
+{
+  const std::vector<double> &left = SweepAndPrune::sorted_min_x;
+
+  // Only boxes starting in [min_x - max_width, max_x] can reach the query
+  size_t first = std::lower_bound(left.begin(), left.end(), min_x - SweepAndPrune::max_width) - left.begin();
+  size_t last = std::upper_bound(left.begin() + first, left.end(), max_x) - left.begin();
+
+  for(size_t i = first; i < last; i++) {
+    const Proxy &p = SweepAndPrune::proxies[SweepAndPrune::sorted_proxies[i]];
+    if(p.max_x >= min_x && p.min_y <= max_y && min_y <= p.max_y) {
+      out.push_back(SweepAndPrune::sorted_proxies[i]);
+    }
+  }
+}
+
+
+/// @brief Allocates room for the given number of proxies, so tracking up to that
+/// many (created, merged, swept and queried) never allocates
+/// @param count
+void SweepAndPrune::reserve(size_t count)
+{
+  SweepAndPrune::proxies.reserve(count);
+  SweepAndPrune::free_proxies.reserve(count);
+  SweepAndPrune::endpoints.reserve(2 * count);
+  SweepAndPrune::new_endpoints.reserve(2 * count);
+  SweepAndPrune::active_players.reserve(count);
+  SweepAndPrune::active_slot.reserve(count);
+  SweepAndPrune::sorted_min_x.reserve(count);
+  SweepAndPrune::sorted_proxies.reserve(count);
+}
+
+
+/// @brief Removes every proxy
+void SweepAndPrune::clear()
+{
+  SweepAndPrune::proxies.clear();
+  SweepAndPrune::free_proxies.clear();
+  SweepAndPrune::endpoints.clear();
+  SweepAndPrune::new_endpoints.clear();
+  SweepAndPrune::active_slot.clear();
+  SweepAndPrune::sorted_min_x.clear();
+  SweepAndPrune::sorted_proxies.clear();
+  SweepAndPrune::max_width = 0;
+  SweepAndPrune::has_destroyed = false;
+}
+
+
+//=========================================
+// Closed interval overlap on the Y axis
+bool SweepAndPrune::overlap_y(int p1, int p2) const
+{
+  const Proxy &a = SweepAndPrune::proxies[p1];
+  const Proxy &b = SweepAndPrune::proxies[p2];
+  return a.min_y <= b.max_y && b.min_y <= a.max_y;
+}
+
+
+//=====================================================
+// Active lists with O(1) removal (swap with the last)
+void SweepAndPrune::activate(std::vector<int> &active, int proxy)
+{
+  SweepAndPrune::active_slot[proxy] = active.size();
+  active.push_back(proxy);
+}
+
+void SweepAndPrune::deactivate(std::vector<int> &active, int proxy)
+{
+  int slot = SweepAndPrune::active_slot[proxy];
+  int last = active.back();
+  active[slot] = last;
+  SweepAndPrune::active_slot[last] = slot;
+  active.pop_back();
+}
+
+
+// Getters===========
+ProxyKind SweepAndPrune::get_kind(int proxy) const
+{
+  return SweepAndPrune::proxies[proxy].kind;
+}
+
+int SweepAndPrune::get_user(int proxy) const
+{
+  return SweepAndPrune::proxies[proxy].user;
+}
+
+int SweepAndPrune::get_proxy_count() const
+{
+  return SweepAndPrune::proxies.size() - SweepAndPrune::free_proxies.size();
+}
@@ -0,0 +1,80 @@
+#ifndef broadphase_h
+#define broadphase_h
+
+#include <vector>
+#include <cstddef>
+
+// Kinds of tracked players (pairs are only reported between different kinds)
+enum ProxyKind {
+  SelfProxy,
+  EnemyProxy
+};
+
+// Candidate pair of proxies whose boxes overlap
+struct ProxyPair {
+  int a;
+  int b;
+};
+
+/// @brief Sweep-and-prune broadphase on the X axis over the players.
+/// The endpoint list is kept sorted across ticks, so re-sorting is nearly linear.
+/// Shots are not tracked (they never pair with each other and would flood the list):
+/// query() finds the players overlapping a shot's box by binary search over the
+/// players sorted by left edge
+class SweepAndPrune {
+
+  struct Proxy {
+    double min_x;
+    double max_x;
+    double min_y;
+    double max_y;
+    ProxyKind kind;
+    int user;     // caller's index of the object
+    bool alive;
+  };
+
+  struct Endpoint {
+    double value;
+    int proxy;
+    bool is_min;
+  };
+
+  // Private by default
+  std::vector<Proxy> proxies = {};
+  std::vector<int> free_proxies = {};
+  std::vector<Endpoint> endpoints = {};      // sorted by value
+  std::vector<Endpoint> new_endpoints = {};  // merged on the next update
+  bool has_destroyed = false;
+
+  // Sweep state (reused between ticks)
+  std::vector<int> active_players = {};
+  std::vector<int> active_slot = {};
+
+  // Players by left edge, for box queries (rebuilt by update())
+  std::vector<double> sorted_min_x = {};
+  std::vector<int> sorted_proxies = {};
+  double max_width = 0;  // widest box, bounds how far left an overlapping box can start
+
+  static bool endpoint_less(const Endpoint &e1, const Endpoint &e2);
+  bool overlap_y(int p1, int p2) const;
+  void activate(std::vector<int> &active, int proxy);
+  void deactivate(std::vector<int> &active, int proxy);
+
+  public:
+    SweepAndPrune(){}
+    int create_proxy(ProxyKind kind, int user, double min_x, double max_x, double min_y, double max_y);
+    void move_proxy(int proxy, int user, double min_x, double max_x, double min_y, double max_y);
+    void destroy_proxy(int proxy);
+    void update();
+    void find_pairs(std::vector<ProxyPair> &out);
+    void query(double min_x, double max_x, double min_y, double max_y, std::vector<int> &out) const;
+    void reserve(size_t count);
+    void clear();
+
+    // getters
+    ProxyKind get_kind(int proxy) const;
+    int get_user(int proxy) const;
+    int get_proxy_count() const;
+};
+
+#endif
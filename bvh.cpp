@@ -0,0 +1,246 @@
+#include "bvh.h"
+#include <algorithm>
+
+// Traversal stack depth (median splits keep the tree depth ~log2(n))
+#define BVH_STACK_SIZE 64
+
+
+/// @brief Builds the hierarchy by median splits on the longest axis
+/// @param rects 
+void Bvh::build(const std::vector<svg_tools::Rect> &rects)
+{
+  Bvh::nodes.clear();
+  Bvh::items.resize(rects.size());
+  Bvh::item_bounds.clear();
+
+  if(rects.empty()) return;
+
+  for(size_t i = 0; i < rects.size(); i++) {
+    Bvh::items[i] = i;
+  }
+
+  Bvh::nodes.reserve(2 * rects.size() / BVH_LEAF_SIZE + 1);
+  Bvh::build_node(rects, 0, rects.size());
+
+  // Leaves bounds laid out in traversal order
+  Bvh::item_bounds.reserve(4 * rects.size());
+  for(int i: Bvh::items) {
+    Bvh::item_bounds.push_back(rects[i].x);
+    Bvh::item_bounds.push_back(rects[i].y);
+    Bvh::item_bounds.push_back(rects[i].x + rects[i].width);
+    Bvh::item_bounds.push_back(rects[i].y + rects[i].height);
+  }
+}
+
+
+//=====================================================================================
+// Recursively builds the node covering items[first .. first+count) and returns its index
+int Bvh::build_node(const std::vector<svg_tools::Rect> &rects, int first, int count)
+{
+  int index = Bvh::nodes.size();
+  Bvh::nodes.push_back({});
+
+  // Node and centroid bounds
+  Node node = { rects[Bvh::items[first]].x, rects[Bvh::items[first]].y, rects[Bvh::items[first]].x, rects[Bvh::items[first]].y, first, count };
+  double c_min_x = node.min_x, c_min_y = node.min_y, c_max_x = node.min_x, c_max_y = node.min_y;
+
+  for(int k = first; k < first + count; k++) {
+    const svg_tools::Rect &r = rects[Bvh::items[k]];
+    node.min_x = std::min(node.min_x, r.x);
+    node.min_y = std::min(node.min_y, r.y);
+    node.max_x = std::max(node.max_x, r.x + r.width);
+    node.max_y = std::max(node.max_y, r.y + r.height);
+
+    double cx = r.x + r.width / 2;
+    double cy = r.y + r.height / 2;
+    c_min_x = std::min(c_min_x, cx);
+    c_min_y = std::min(c_min_y, cy);
+    c_max_x = std::max(c_max_x, cx);
+    c_max_y = std::max(c_max_y, cy);
+  }
+
+  // Leaf
+  if(count <= BVH_LEAF_SIZE) {
+    Bvh::nodes[index] = node;
+    return index;
+  }
+
+  // Median split on the longest centroid axis
+  bool split_x = (c_max_x - c_min_x) >= (c_max_y - c_min_y);
+  int half = count / 2;
+  std::nth_element(
+    Bvh::items.begin() + first,
+    Bvh::items.begin() + first + half,
+    Bvh::items.begin() + first + count,
+    [&rects, split_x](int a, int b) {
+      return split_x 
+        ? (rects[a].x + rects[a].width / 2) < (rects[b].x + rects[b].width / 2)
+        : (rects[a].y + rects[a].height / 2) < (rects[b].y + rects[b].height / 2);
+    }
+  );
+
+  // Left child is the next node; right child index is stored in offset
+  Bvh::build_node(rects, first, half);
+  node.offset = Bvh::build_node(rects, first + half, count - half);
+  node.count = 0;
+  Bvh::nodes[index] = node;
+  return index;
+}
+
+
+/// @brief Appends to out the indices of rectangles overlapping the region
+/// @param left 
+/// @param top 
+/// @param right 
+/// @param bottom 
+/// @param out 
+void Bvh::query(double left, double top, double right, double bottom, std::vector<int> &out) const
+{
+  if(Bvh::nodes.empty()) return;
+
+  int stack[BVH_STACK_SIZE];
+  int top_of_stack = 0;
+  stack[top_of_stack++] = 0;
+
+  while(top_of_stack > 0) {
+    int index = stack[--top_of_stack];
+    const Node &node = Bvh::nodes[index];
+
+    if(node.min_x > right || node.max_x < left || node.min_y > bottom || node.max_y < top) {
+      continue;
+    }
+
+    // Leaf: testing its rectangles
+    if(node.count > 0) {
+      for(int k = node.offset; k < node.offset + node.count; k++) {
+        const double *b = &Bvh::item_bounds[4 * k];
+        if(!(b[0] > right || b[2] < left || b[1] > bottom || b[3] < top)) {
+          out.push_back(Bvh::items[k]);
+        }
+      }
+      continue;
+    }
+
+    stack[top_of_stack++] = node.offset;
+    stack[top_of_stack++] = index + 1;
+  }
+}
+
+
+/// @brief Finds the first rectangle hit by the segment (x0,y0)->(x1,y1)
+/// @param hit index of the rectangle
+/// @param t segment parameter in [0, 1] of the entry point
+/// @return true if any rectangle is hit
+bool Bvh::raycast(double x0, double y0, double x1, double y1, int &hit, double &t) const
+{
+  if(Bvh::nodes.empty()) return false;
+
+  double dx = x1 - x0;
+  double dy = y1 - y0;
+  double best = 1.0;
+  bool found = false;
+
+  int stack[BVH_STACK_SIZE];
+  int top_of_stack = 0;
+  stack[top_of_stack++] = 0;
+
+  while(top_of_stack > 0) {
+    const int index = stack[--top_of_stack];
+    const Node &node = Bvh::nodes[index];
+    double t_node;
+
+    // Skipping nodes farther than the closest hit
+    if(!geometry_tools::segment_hits_box(x0, y0, dx, dy, node.min_x, node.min_y, node.max_x, node.max_y, best, t_node)) {
+      continue;
+    }
+
+    if(node.count > 0) {
+      for(int k = node.offset; k < node.offset + node.count; k++) {
+        const double *b = &Bvh::item_bounds[4 * k];
+        double t_item;
+        if(geometry_tools::segment_hits_box(x0, y0, dx, dy, b[0], b[1], b[2], b[3], best, t_item)) {
+          if(!found || t_item < best) {
+            best = t_item;
+            hit = Bvh::items[k];
+            found = true;
+          }
+        }
+      }
+      continue;
+    }
+
+    stack[top_of_stack++] = node.offset;
+    stack[top_of_stack++] = index + 1;
+  }
+
+  if(found) t = best;
+  return found;
+}
+
+
+/// @brief Writes the built hierarchy (8 bytes aligned arrays)
+/// @param snapshot
+void Bvh::save(Snapshot &snapshot) const
+{
+  snapshot.align_write(8);
+  snapshot.put_vector(Bvh::nodes, Bvh::nodes.size());
+  snapshot.align_write(8);
+  snapshot.put_vector(Bvh::items, Bvh::items.size());
+  snapshot.align_write(8);
+  snapshot.put_vector(Bvh::item_bounds, Bvh::item_bounds.size());
+}
+
+
+/// @brief Reads a hierarchy written by save() (no rebuild) and checks that every child
+/// and item range stays inside the arrays and that traversals fit their stack
+/// @param snapshot
+/// @param obstacle_count obstacles of the arena the hierarchy was built over
+/// @return false if the hierarchy is truncated or inconsistent (the hierarchy is left empty)
+bool Bvh::restore(Snapshot &snapshot, size_t obstacle_count)
+{
+  snapshot.align_read(8);
+  snapshot.get_vector(Bvh::nodes);
+  snapshot.align_read(8);
+  snapshot.get_vector(Bvh::items);
+  snapshot.align_read(8);
+  snapshot.get_vector(Bvh::item_bounds);
+
+  bool ok =
+    !snapshot.is_overrun() &&
+    Bvh::items.size() == obstacle_count &&
+    Bvh::item_bounds.size() == 4 * obstacle_count &&
+    Bvh::nodes.empty() == Bvh::items.empty();
+
+  for(size_t k = 0; ok && k < Bvh::items.size(); k++) {
+    ok = Bvh::items[k] >= 0 && (size_t)Bvh::items[k] < obstacle_count;
+  }
+
+  // Children come after their parent (no cycles), so depths are known in one pass
+  std::vector<int> depth(Bvh::nodes.size(), 0);
+  for(size_t i = 0; ok && i < Bvh::nodes.size(); i++) {
+    const Node &node = Bvh::nodes[i];
+    if(node.count > 0) {
+      ok = node.count <= BVH_LEAF_SIZE && node.offset >= 0 &&
+           (size_t)node.offset + node.count <= Bvh::items.size();
+      continue;
+    }
+
+    ok = node.count == 0 && i + 1 < Bvh::nodes.size() &&
+         node.offset > (int)i + 1 && (size_t)node.offset < Bvh::nodes.size() &&
+         depth[i] + 2 < BVH_STACK_SIZE;
+    if(ok) {
+      depth[i + 1] = std::max(depth[i + 1], depth[i] + 1);
+      depth[node.offset] = std::max(depth[node.offset], depth[i] + 1);
+    }
+  }
+
+  if(!ok) *this = Bvh();
+  return ok;
+}
+
+
+// Getters===========
+int Bvh::get_node_count() const
+{
+  return Bvh::nodes.size();
+}
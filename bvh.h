@@ -0,0 +1,45 @@
+#ifndef bvh_h
+#define bvh_h
+
+#include <vector>
+#include "utils.h"
+#include "snapshot.h"
+
+// Rectangles per leaf
+#define BVH_LEAF_SIZE 4
+
+/// @brief Static AABB bounding volume hierarchy over rectangles.
+/// Nodes are flattened depth-first: the left child follows its parent
+class Bvh {
+
+  struct Node {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+    int offset;   // leaf: first item / internal: right child
+    int count;    // leaf: number of items / internal: 0
+  };
+
+  // Private by default
+  std::vector<Node> nodes = {};
+  std::vector<int> items = {};
+
+  // Copy of the rectangles bounds in items order (leaves read contiguous memory)
+  std::vector<double> item_bounds = {};
+
+  int build_node(const std::vector<svg_tools::Rect> &rects, int first, int count);
+
+  public:
+    Bvh(){}
+    void build(const std::vector<svg_tools::Rect> &rects);
+    void query(double left, double top, double right, double bottom, std::vector<int> &out) const;
+    bool raycast(double x0, double y0, double x1, double y1, int &hit, double &t) const;
+    void save(Snapshot &snapshot) const;
+    bool restore(Snapshot &snapshot, size_t obstacle_count);
+
+    // getters
+    int get_node_count() const;
+};
+
+#endif
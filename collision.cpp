@@ -0,0 +1,280 @@
+#include "collision.h"
+#include "job_system.h"
+#include <cmath>
+#include <algorithm>
+
+
+//======================================================
+// Fills the optional contact output
+static void set_contact(Contact *contact, double normal_x, double normal_y, double penetration)
+{
+  if(contact == nullptr) return;
+  contact->normal[0] = normal_x;
+  contact->normal[1] = normal_y;
+  contact->penetration = penetration;
+}
+
+
+/// @brief Binds the world to the arena and the enemies (kept as views, never copied)
+/// @param arena 
+/// @param enemies 
+void CollisionWorld::setup(const Arena &arena, const std::vector<Player> &enemies)
+{
+  CollisionWorld::arena = &arena;
+  CollisionWorld::enemies = &enemies;
+  if(CollisionWorld::nearby.empty()) CollisionWorld::nearby.resize(1);
+  index_enemies();
+}
+
+
+/// @brief Allocates the query storage up front, so indexing up to the given number of
+/// enemies and querying from the job system threads never allocates
+/// @param enemies
+/// @param obstacles most obstacles a query can report (the arena's obstacles)
+/// @param threads job system threads running queries
+void CollisionWorld::reserve(size_t enemies, size_t obstacles, unsigned threads)
+{
+  CollisionWorld::bucket_enemies.reserve(enemies);
+  CollisionWorld::nearby.resize(std::max(threads, 1u));
+  for(std::vector<int> &candidates: CollisionWorld::nearby) {
+    candidates.reserve(obstacles);
+  }
+}
+
+
+//======================================================
+// Bucket of an x coordinate (clamped to the arena)
+size_t CollisionWorld::enemy_bucket(double x) const
+{
+  double bucket = (x - arena->get_x()) / ENEMY_BUCKET_WIDTH;
+  if(!(bucket > 0)) return 0;
+  return std::min((size_t)bucket, bucket_start.size() - 2);
+}
+
+
+/// @brief Buckets the enemies by left edge (counting sort, linear in the enemies).
+/// Call after the enemies move and before sweeping against them
+void CollisionWorld::index_enemies()
+{
+  const std::vector<Player> &enemies = *CollisionWorld::enemies;
+  size_t buckets = (size_t)(arena->get_width() / ENEMY_BUCKET_WIDTH) + 1;
+
+  // Bucket sizes, then their ends
+  bucket_start.assign(buckets + 1, 0);
+  enemy_max_width = 0;
+  for(const Player &enemy: enemies) {
+    bucket_start[enemy_bucket(enemy.get_left_edge())]++;
+    enemy_max_width = std::max(enemy_max_width, enemy.get_right_edge() - enemy.get_left_edge());
+  }
+  for(size_t b = 1; b <= buckets; b++) {
+    bucket_start[b] += bucket_start[b - 1];
+  }
+
+  // Filling backwards leaves each bucket in enemy order and its entry at its start
+  bucket_enemies.resize(enemies.size());
+  for(size_t i = enemies.size(); i-- > 0;) {
+    bucket_enemies[--bucket_start[enemy_bucket(enemies[i].get_left_edge())]] = i;
+  }
+}
+
+
+//============================================
+// Checks collision against 2 players
+bool CollisionWorld::players_collision(const Player &p1, const Player &p2) {
+  if(
+    ((p1.get_right_edge() >= p2.get_left_edge() && p1.get_left_edge() <= p2.get_left_edge()) ||
+    (p1.get_left_edge() <= p2.get_right_edge() && p1.get_right_edge() >= p2.get_right_edge()))
+    &&
+    ((p1.get_bottom_edge() >= p2.get_top_edge() && p1.get_top_edge() <= p2.get_top_edge()) ||
+    (p1.get_top_edge() <= p2.get_bottom_edge() && p1.get_bottom_edge() >= p2.get_bottom_edge()))
+  ){
+    return true;
+  }
+  return false;
+}
+
+
+//=====================================================
+// Detect platform limit under the player
+bool CollisionWorld::platform_end_detected(const Player &player) const
+{
+  const Arena &arena = *CollisionWorld::arena;
+
+  double floor_offset = 1;
+
+  //arena collision
+  if(player.get_walk_direction() == HorizontalMoveDirection::Left) {
+    if(player.get_left_edge() <= arena.get_x()) return true;
+  }
+  else if(player.get_right_edge() >= (arena.get_x() + arena.get_width())) {
+    return true;
+  }
+
+  // Only obstacles around the player can be reached
+  std::vector<int> &nearby = CollisionWorld::nearby[JobSystem::get_current_thread()];
+  nearby.clear();
+  arena.query_obstacles(
+    player.get_left_edge(), 
+    player.get_top_edge(), 
+    player.get_right_edge(), 
+    player.get_bottom_edge() + floor_offset, 
+    nearby
+  );
+
+  for(int i: nearby) {
+    const svg_tools::Rect& r = arena.get_obstacle(i);
+    
+    // Check if player is over an obstacle
+    if(std::abs(player.get_bottom_edge() - r.y) <= floor_offset){
+      if(
+        (player.get_left_edge() <= r.x && player.get_right_edge() >= r.x) ||
+        (player.get_right_edge() >= (r.x + r.width) && player.get_left_edge() <= (r.x + r.width))
+      ){
+        return true;
+      }
+    }
+
+    // Treats players not over obstacles==========
+    else if(player.get_walk_direction() == HorizontalMoveDirection::Left) {
+      // obstacles collision
+      if( 
+      (player.get_left_edge() <= (r.x + r.width)) &&  
+      (player.get_left_edge() >= (r.x)) &&
+      (
+        (((r.y + r.height) >= player.get_top_edge()) && 
+         ((r.y) <= player.get_top_edge())
+        ) ||
+        
+        ( ((r.y) <= player.get_bottom_edge()) &&
+          ((r.y + r.height) >= player.get_bottom_edge())
+        ) ||
+        (((r.y) >= player.get_top_edge()) &&
+         (r.y + r.height) <= player.get_bottom_edge()
+        )
+      )
+      ){
+        return true;
+      }
+    }
+
+    // Rightward motion====
+    else {
+      // obstacles collision
+      if(
+        // by width 
+        (player.get_right_edge() >= (r.x)) &&  
+        (player.get_right_edge() <= (r.x + r.width)) &&
+        // by height
+        ( 
+          (((r.y + r.height) >= player.get_top_edge()) && 
+           ((r.y) <= player.get_top_edge())
+          ) || 
+
+          ( ((r.y) <= player.get_bottom_edge()) &&
+            ((r.y + r.height) >= player.get_bottom_edge())
+          ) ||
+  
+          (((r.y) >= player.get_top_edge()) && 
+           (r.y + r.height) <= player.get_bottom_edge()
+          )
+        )
+      ){
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+
+
+
+//==================================================================================================
+// Limits one axis of a sweep by a blocker edge ahead of the player.
+// gap: distance from the player to the edge along the motion
+// overlap: the blocker spans the player across the motion
+static void limit_sweep(
+  double gap, double distance, bool overlap, double normal_x, double normal_y,
+  double &allowed, Contact *contact)
+{
+  if(!overlap || gap < -SWEEP_SKIN) return;   // beside the motion or already behind the player
+
+  // Resting contact (a negative gap is the depth the player starts overlapping by);
+  // swept hits stop at the time of impact, with no penetration
+  double penetration = 0;
+  if(gap < SWEEP_SKIN) {
+    penetration = std::max(-gap, 0.0);
+    gap = 0;
+  }
+
+  if(gap < allowed * distance) {
+    allowed = gap / distance;
+    set_contact(contact, normal_x, normal_y, penetration);
+  }
+}
+
+
+//==================================================================================================
+// Swept player box: fraction of the motion (dx, dy) done before touching the arena limits,
+// an obstacle or an enemy. Players move along one axis at a time, so only one of dx, dy is used
+double CollisionWorld::sweep(const Player &player, double dx, double dy, Contact *contact) const
+{
+  const Arena &arena = *CollisionWorld::arena;
+  const std::vector<Player> &enemies = *CollisionWorld::enemies;
+
+  double left = player.get_left_edge();
+  double right = player.get_right_edge();
+  double top = player.get_top_edge();
+  double bottom = player.get_bottom_edge();
+  double allowed = 1;
+
+  if(dx == 0 && dy == 0) return allowed;
+
+  // Normal pointing towards the player (Y grows downward)
+  double normal_x = (dx > 0) ? -1 : (dx < 0) ? 1 : 0;
+  double normal_y = (dx != 0) ? 0 : (dy > 0) ? -1 : 1;
+
+  // Boxes touching the player sideways (within the skin) do not block the motion
+  auto block = [&](double box_left, double box_top, double box_right, double box_bottom) {
+    bool spans_vertically = box_top < bottom - SWEEP_SKIN && box_bottom > top + SWEEP_SKIN;
+    bool spans_horizontally = box_left < right - SWEEP_SKIN && box_right > left + SWEEP_SKIN;
+
+    if(dx > 0) {
+      limit_sweep(box_left - right, dx, spans_vertically, normal_x, normal_y, allowed, contact);
+    } else if(dx < 0) {
+      limit_sweep(left - box_right, -dx, spans_vertically, normal_x, normal_y, allowed, contact);
+    } else if(dy > 0) {
+      limit_sweep(box_top - bottom, dy, spans_horizontally, normal_x, normal_y, allowed, contact);
+    } else {
+      limit_sweep(top - box_bottom, -dy, spans_horizontally, normal_x, normal_y, allowed, contact);
+    }
+  };
+
+  // Arena limits
+  if(dx > 0) limit_sweep(arena.get_x() + arena.get_width() - right, dx, true, normal_x, normal_y, allowed, contact);
+  else if(dx < 0) limit_sweep(left - arena.get_x(), -dx, true, normal_x, normal_y, allowed, contact);
+  else if(dy > 0) limit_sweep(arena.get_y() + arena.get_height() - bottom, dy, true, normal_x, normal_y, allowed, contact);
+  else limit_sweep(top - arena.get_y(), -dy, true, normal_x, normal_y, allowed, contact);
+
+  // Obstacles around the motion
+  std::vector<int> &nearby = CollisionWorld::nearby[JobSystem::get_current_thread()];
+  nearby.clear();
+  arena.query_obstacles(
+    std::min(left, left + dx), std::min(top, top + dy), std::max(right, right + dx), std::max(bottom, bottom + dy), nearby
+  );
+  for(int i: nearby) {
+    const svg_tools::Rect& r = arena.get_obstacle(i);
+    block(r.x, r.y, r.x + r.width, r.y + r.height);
+  }
+
+  // Enemies in the buckets the motion reaches (a player never blocks itself)
+  size_t first = bucket_start[enemy_bucket(std::min(left, left + dx) - enemy_max_width)];
+  size_t last = bucket_start[enemy_bucket(std::max(right, right + dx)) + 1];
+  for(size_t k = first; k < last; k++) {
+    const Player &enemy = enemies[bucket_enemies[k]];
+    if(&enemy == &player) continue;
+    block(enemy.get_left_edge(), enemy.get_top_edge(), enemy.get_right_edge(), enemy.get_bottom_edge());
+  }
+
+  return allowed;
+}
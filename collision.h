@@ -0,0 +1,50 @@
+#ifndef collision_h
+#define collision_h
+
+#include <vector>
+#include "utils.h"
+#include "arena.h"
+#include "player.h"
+
+// Distances below this are contact (absorbs rounding when resting against a box)
+#define SWEEP_SKIN 1e-6
+// Width of the enemy buckets used by sweeps
+#define ENEMY_BUCKET_WIDTH 64
+
+/// @brief Contact reported by a collision query
+struct Contact {
+  double normal[2];     // unit normal pointing towards the player (Y grows downward)
+  double penetration;   // overlap depth along the normal when the motion starts overlapping, else 0
+};
+
+/// @brief Collision queries over views of the arena and the enemies.
+/// Nothing is copied and queries do not allocate
+class CollisionWorld {
+
+  // Private by default
+  const Arena *arena = nullptr;
+  const std::vector<Player> *enemies = nullptr;
+
+  // Enemies bucketed by left edge (rebuilt each tick by index_enemies())
+  std::vector<int> bucket_start = {};    // first entry of each bucket, plus the end
+  std::vector<int> bucket_enemies = {};  // enemy indices grouped by bucket
+  double enemy_max_width = 0;            // bounds how far left an overlapping enemy can start
+
+  // Obstacle candidates of each job system thread (reused, no per-query allocation)
+  mutable std::vector<std::vector<int>> nearby = {};
+
+  size_t enemy_bucket(double x) const;
+
+  public:
+    CollisionWorld(){}
+    void setup(const Arena &arena, const std::vector<Player> &enemies);
+    void reserve(size_t enemies, size_t obstacles, unsigned threads);
+    void index_enemies();
+
+    // queries
+    double sweep(const Player &player, double dx, double dy, Contact *contact = nullptr) const;
+    bool platform_end_detected(const Player &player) const;
+    static bool players_collision(const Player &p1, const Player &p2);
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "grid.h"
+#include <algorithm>
+#include <cmath>
+
+// Cells per rectangle budget (bounds grid memory for sparse levels)
+#define GRID_MAX_CELLS_PER_RECT 4
+#define GRID_MIN_CELLS 64
+
+
+/// @brief Builds the grid. Cell size is twice the mean rectangle extent,
+/// enlarged when needed to keep the number of cells proportional to the rectangles
+/// @param rects 
+void Grid::build(const std::vector<svg_tools::Rect> &rects)
+{
+  Grid::cell_start.clear();
+  Grid::cell_items.clear();
+  Grid::first_column.clear();
+  Grid::first_row.clear();
+  Grid::columns = 0;
+  Grid::rows = 0;
+
+  if(rects.empty()) return;
+
+  // Obstacles statistics====================
+  double min_x = rects[0].x;
+  double min_y = rects[0].y;
+  double max_x = rects[0].x + rects[0].width;
+  double max_y = rects[0].y + rects[0].height;
+  double extent_sum = 0;
+
+  for(const svg_tools::Rect &r: rects) {
+    min_x = std::min(min_x, r.x);
+    min_y = std::min(min_y, r.y);
+    max_x = std::max(max_x, r.x + r.width);
+    max_y = std::max(max_y, r.y + r.height);
+    extent_sum += std::max(r.width, r.height);
+  }
+
+  double width = std::max(max_x - min_x, 1e-6);
+  double height = std::max(max_y - min_y, 1e-6);
+  double max_cells = std::max((double)GRID_MIN_CELLS, (double)GRID_MAX_CELLS_PER_RECT * rects.size());
+
+  Grid::cell_size = std::max(2 * extent_sum / rects.size(), 1e-6);
+  Grid::cell_size = std::max(Grid::cell_size, std::sqrt(width * height / max_cells));
+  Grid::cell_size = std::max({ Grid::cell_size, width / max_cells, height / max_cells });  // thin levels
+
+  Grid::origin_x = min_x;
+  Grid::origin_y = min_y;
+  Grid::columns = (int)std::ceil(width / Grid::cell_size) + 1;
+  Grid::rows = (int)std::ceil(height / Grid::cell_size) + 1;
+
+  // Counting rectangles per cell===========
+  std::vector<int> count(Grid::columns * Grid::rows + 1, 0);
+  Grid::first_column.resize(rects.size());
+  Grid::first_row.resize(rects.size());
+
+  for(size_t i = 0; i < rects.size(); i++) {
+    const svg_tools::Rect &r = rects[i];
+    int c0 = column_of(r.x), c1 = column_of(r.x + r.width);
+    int r0 = row_of(r.y), r1 = row_of(r.y + r.height);
+    Grid::first_column[i] = c0;
+    Grid::first_row[i] = r0;
+
+    for(int row = r0; row <= r1; row++) {
+      for(int col = c0; col <= c1; col++) {
+        count[row * Grid::columns + col]++;
+      }
+    }
+  }
+
+  // Prefix sum gives each cell's first slot
+  Grid::cell_start.assign(count.size(), 0);
+  for(size_t c = 1; c < count.size(); c++) {
+    Grid::cell_start[c] = Grid::cell_start[c - 1] + count[c - 1];
+  }
+
+  // Filling cells========================
+  std::vector<int> cursor(Grid::cell_start.begin(), Grid::cell_start.end() - 1);
+  Grid::cell_items.resize(Grid::cell_start.back());
+
+  for(size_t i = 0; i < rects.size(); i++) {
+    const svg_tools::Rect &r = rects[i];
+    int c1 = column_of(r.x + r.width);
+    int r1 = row_of(r.y + r.height);
+
+    for(int row = Grid::first_row[i]; row <= r1; row++) {
+      for(int col = Grid::first_column[i]; col <= c1; col++) {
+        Grid::cell_items[cursor[row * Grid::columns + col]++] = i;
+      }
+    }
+  }
+}
+
+
+/// @brief Appends to out the indices of rectangles in cells touched by the region.
+/// Candidates may not overlap the region; callers run the exact test
+/// @param left 
+/// @param top 
+/// @param right 
+/// @param bottom 
+/// @param out 
+void Grid::query(double left, double top, double right, double bottom, std::vector<int> &out) const
+{
+  if(Grid::columns == 0) return;
+
+  int c0 = column_of(left), c1 = column_of(right);
+  int r0 = row_of(top), r1 = row_of(bottom);
+
+  for(int row = r0; row <= r1; row++) {
+    for(int col = c0; col <= c1; col++) {
+      int cell = row * Grid::columns + col;
+
+      for(int k = Grid::cell_start[cell]; k < Grid::cell_start[cell + 1]; k++) {
+        int i = Grid::cell_items[k];
+
+        // Reporting only at the first cell shared by the rectangle and the region
+        if(col == std::max(c0, Grid::first_column[i]) && row == std::max(r0, Grid::first_row[i])) {
+          out.push_back(i);
+        }
+      }
+    }
+  }
+}
+
+
+/// @brief Writes the built grid (8 bytes aligned arrays)
+/// @param snapshot
+void Grid::save(Snapshot &snapshot) const
+{
+  snapshot.put(Grid::origin_x);
+  snapshot.put(Grid::origin_y);
+  snapshot.put(Grid::cell_size);
+  snapshot.put(Grid::columns);
+  snapshot.put(Grid::rows);
+
+  const std::vector<int> *arrays[] = { &(Grid::cell_start), &(Grid::cell_items), &(Grid::first_column), &(Grid::first_row) };
+  for(const std::vector<int> *array: arrays) {
+    snapshot.align_write(8);
+    snapshot.put_vector(*array, array->size());
+  }
+}
+
+
+/// @brief Reads a grid written by save() (no rebuild) and checks that every cell range
+/// and obstacle index stays inside the arrays
+/// @param snapshot
+/// @param obstacle_count obstacles of the arena the grid was built over
+/// @return false if the grid is truncated or inconsistent (the grid is left empty)
+bool Grid::restore(Snapshot &snapshot, size_t obstacle_count)
+{
+  snapshot.get(Grid::origin_x);
+  snapshot.get(Grid::origin_y);
+  snapshot.get(Grid::cell_size);
+  snapshot.get(Grid::columns);
+  snapshot.get(Grid::rows);
+
+  std::vector<int> *arrays[] = { &(Grid::cell_start), &(Grid::cell_items), &(Grid::first_column), &(Grid::first_row) };
+  for(std::vector<int> *array: arrays) {
+    snapshot.align_read(8);
+    snapshot.get_vector(*array);
+  }
+
+  if(snapshot.is_overrun()) {
+    *this = Grid();
+    return false;
+  }
+
+  // Grids over no obstacles are never built
+  if(obstacle_count == 0) {
+    bool empty = Grid::columns == 0 && Grid::rows == 0 && Grid::cell_start.empty() && Grid::cell_items.empty() &&
+                 Grid::first_column.empty() && Grid::first_row.empty();
+    if(!empty) *this = Grid();
+    return empty;
+  }
+
+  bool ok =
+    std::isfinite(Grid::origin_x) && std::isfinite(Grid::origin_y) &&
+    std::isfinite(Grid::cell_size) && Grid::cell_size > 0 &&
+    Grid::columns > 0 && Grid::rows > 0 &&
+    Grid::cell_start.size() == (size_t)Grid::columns * Grid::rows + 1 &&
+    Grid::first_column.size() == obstacle_count && Grid::first_row.size() == obstacle_count;
+
+  // Cell ranges: ascending, from the first item to the last
+  ok = ok && Grid::cell_start.front() == 0 && (size_t)Grid::cell_start.back() == Grid::cell_items.size();
+  for(size_t c = 1; ok && c < Grid::cell_start.size(); c++) {
+    ok = Grid::cell_start[c - 1] <= Grid::cell_start[c];
+  }
+  for(size_t k = 0; ok && k < Grid::cell_items.size(); k++) {
+    ok = Grid::cell_items[k] >= 0 && (size_t)Grid::cell_items[k] < obstacle_count;
+  }
+  for(size_t i = 0; ok && i < obstacle_count; i++) {
+    ok = Grid::first_column[i] >= 0 && Grid::first_column[i] < Grid::columns &&
+         Grid::first_row[i] >= 0 && Grid::first_row[i] < Grid::rows;
+  }
+
+  if(!ok) *this = Grid();
+  return ok;
+}
+
+
+//============================================
+// Cell coordinates clamped into the grid
+int Grid::column_of(double x) const
+{
+  int col = (int)std::floor((x - Grid::origin_x) / Grid::cell_size);
+  return std::min(std::max(col, 0), Grid::columns - 1);
+}
+
+int Grid::row_of(double y) const
+{
+  int row = (int)std::floor((y - Grid::origin_y) / Grid::cell_size);
+  return std::min(std::max(row, 0), Grid::rows - 1);
+}
+
+
+// Getters===========
+double Grid::get_cell_size() const
+{
+  return Grid::cell_size;
+}
+
+int Grid::get_columns() const
+{
+  return Grid::columns;
+}
+
+int Grid::get_rows() const
+{
+  return Grid::rows;
+}
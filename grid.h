@@ -0,0 +1,42 @@
+#ifndef grid_h
+#define grid_h
+
+#include <vector>
+#include "utils.h"
+#include "snapshot.h"
+
+/// @brief Uniform grid over static rectangles, built once and queried by region
+class Grid {
+
+  // Private by default
+  double origin_x = 0;
+  double origin_y = 0;
+  double cell_size = 1;
+  int columns = 0;
+  int rows = 0;
+
+  // Flattened cells: items of cell c are cell_items[cell_start[c] .. cell_start[c+1])
+  std::vector<int> cell_start = {};
+  std::vector<int> cell_items = {};
+
+  // First cell covered by each rectangle (reports a rectangle only once per query)
+  std::vector<int> first_column = {};
+  std::vector<int> first_row = {};
+
+  int column_of(double x) const;
+  int row_of(double y) const;
+
+  public:
+    Grid(){}
+    void build(const std::vector<svg_tools::Rect> &rects);
+    void query(double left, double top, double right, double bottom, std::vector<int> &out) const;
+    void save(Snapshot &snapshot) const;
+    bool restore(Snapshot &snapshot, size_t obstacle_count);
+
+    // getters
+    double get_cell_size() const;
+    int get_columns() const;
+    int get_rows() const;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "hit_batch.h"
+#include <immintrin.h>
+#include <algorithm>
+
+
+//==============================================================================
+// Hit kernels: slab test of the segment (x0, y0) -> (x1, y1) against a closed box.
+// A motionless axis only checks the point is inside the slab.
+// Both produce the same results
+static void test_scalar(
+  const double *x0, const double *y0, const double *x1, const double *y1,
+  const double *left, const double *top, const double *right, const double *bottom,
+  uint64_t *hits, double *times, size_t begin, size_t end)
+{
+  for(size_t i = begin; i < end; i++) {
+    double dx = x1[i] - x0[i];
+    double dy = y1[i] - y0[i];
+    double t_enter = 0;
+    double t_exit = 1;
+
+    // X slab
+    if(dx == 0) {
+      if(x0[i] < left[i] || x0[i] > right[i]) t_enter = 2;
+    } else {
+      double t1 = (left[i] - x0[i]) / dx;
+      double t2 = (right[i] - x0[i]) / dx;
+      t_enter = std::max(t_enter, std::min(t1, t2));
+      t_exit = std::min(t_exit, std::max(t1, t2));
+    }
+
+    // Y slab
+    if(dy == 0) {
+      if(y0[i] < top[i] || y0[i] > bottom[i]) t_enter = 2;
+    } else {
+      double t1 = (top[i] - y0[i]) / dy;
+      double t2 = (bottom[i] - y0[i]) / dy;
+      t_enter = std::max(t_enter, std::min(t1, t2));
+      t_exit = std::min(t_exit, std::max(t1, t2));
+    }
+
+    times[i] = t_enter;
+    hits[i >> 6] |= (uint64_t)(t_enter <= t_exit) << (i & 63);
+  }
+}
+
+// One axis of the slab test for 4 segments
+__attribute__((target("avx2")))
+static inline void slab_avx2(__m256d p, __m256d d, __m256d min, __m256d max, __m256d &t_enter, __m256d &t_exit)
+{
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d outside = _mm256_set1_pd(2);
+
+  __m256d t1 = _mm256_div_pd(_mm256_sub_pd(min, p), d);
+  __m256d t2 = _mm256_div_pd(_mm256_sub_pd(max, p), d);
+  __m256d moving_enter = _mm256_max_pd(t_enter, _mm256_min_pd(t1, t2));
+  __m256d moving_exit = _mm256_min_pd(t_exit, _mm256_max_pd(t1, t2));
+
+  // Motionless lanes keep their times, unless the point is out of the slab
+  __m256d still = _mm256_cmp_pd(d, zero, _CMP_EQ_OQ);
+  __m256d out = _mm256_or_pd(_mm256_cmp_pd(p, min, _CMP_LT_OQ), _mm256_cmp_pd(p, max, _CMP_GT_OQ));
+  __m256d still_enter = _mm256_blendv_pd(t_enter, outside, out);
+
+  t_enter = _mm256_blendv_pd(moving_enter, still_enter, still);
+  t_exit = _mm256_blendv_pd(moving_exit, t_exit, still);
+}
+
+__attribute__((target("avx2")))
+static void test_avx2(
+  const double *x0, const double *y0, const double *x1, const double *y1,
+  const double *left, const double *top, const double *right, const double *bottom,
+  uint64_t *hits, double *times, size_t count)
+{
+  size_t i = 0;
+
+  // 4 tests per iteration (never crossing a 64 bits word)
+  for(; i + 4 <= count; i += 4) {
+    __m256d px = _mm256_loadu_pd(x0 + i);
+    __m256d py = _mm256_loadu_pd(y0 + i);
+    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x1 + i), px);
+    __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y1 + i), py);
+    __m256d t_enter = _mm256_setzero_pd();
+    __m256d t_exit = _mm256_set1_pd(1);
+
+    slab_avx2(px, dx, _mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i), t_enter, t_exit);
+    slab_avx2(py, dy, _mm256_loadu_pd(top + i), _mm256_loadu_pd(bottom + i), t_enter, t_exit);
+
+    _mm256_storeu_pd(times + i, t_enter);
+    hits[i >> 6] |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(t_enter, t_exit, _CMP_LE_OQ)) << (i & 63);
+  }
+
+  // Remaining tests
+  test_scalar(x0, y0, x1, y1, left, top, right, bottom, hits, times, i, count);
+}
+
+
+/// @brief Allocates room for the given number of tests, so batches up to it never allocate
+/// @param tests
+void HitBatch::reserve(size_t tests)
+{
+  HitBatch::from_x.reserve(tests);
+  HitBatch::from_y.reserve(tests);
+  HitBatch::to_x.reserve(tests);
+  HitBatch::to_y.reserve(tests);
+  HitBatch::left.reserve(tests);
+  HitBatch::top.reserve(tests);
+  HitBatch::right.reserve(tests);
+  HitBatch::bottom.reserve(tests);
+  HitBatch::hits.reserve((tests + 63) / 64);
+  HitBatch::times.reserve(tests);
+}
+
+
+/// @brief Drops every queued test (keeps the storage)
+void HitBatch::clear()
+{
+  HitBatch::from_x.clear();
+  HitBatch::from_y.clear();
+  HitBatch::to_x.clear();
+  HitBatch::to_y.clear();
+  HitBatch::left.clear();
+  HitBatch::top.clear();
+  HitBatch::right.clear();
+  HitBatch::bottom.clear();
+  HitBatch::hits.clear();
+  HitBatch::times.clear();
+}
+
+
+/// @brief Queues a test of the motion (x0, y0) -> (x1, y1) against a box
+/// @param x0
+/// @param y0
+/// @param x1
+/// @param y1
+/// @param left
+/// @param top
+/// @param right
+/// @param bottom
+/// @return index of the test, to read its result after run()
+size_t HitBatch::add(double x0, double y0, double x1, double y1, double left, double top, double right, double bottom)
+{
+  HitBatch::from_x.push_back(x0);
+  HitBatch::from_y.push_back(y0);
+  HitBatch::to_x.push_back(x1);
+  HitBatch::to_y.push_back(y1);
+  HitBatch::left.push_back(left);
+  HitBatch::top.push_back(top);
+  HitBatch::right.push_back(right);
+  HitBatch::bottom.push_back(bottom);
+
+  return HitBatch::from_x.size() - 1;
+}
+
+
+/// @brief Runs every queued test
+void HitBatch::run()
+{
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  size_t count = HitBatch::from_x.size();
+
+  HitBatch::hits.assign((count + 63) / 64, 0);
+  HitBatch::times.resize(count);
+
+  if(HitBatch::simd && has_avx2) {
+    test_avx2(
+      HitBatch::from_x.data(), HitBatch::from_y.data(), HitBatch::to_x.data(), HitBatch::to_y.data(),
+      HitBatch::left.data(), HitBatch::top.data(), HitBatch::right.data(), HitBatch::bottom.data(),
+      HitBatch::hits.data(), HitBatch::times.data(), count
+    );
+    return;
+  }
+
+  test_scalar(
+    HitBatch::from_x.data(), HitBatch::from_y.data(), HitBatch::to_x.data(), HitBatch::to_y.data(),
+    HitBatch::left.data(), HitBatch::top.data(), HitBatch::right.data(), HitBatch::bottom.data(),
+    HitBatch::hits.data(), HitBatch::times.data(), 0, count
+  );
+}
+
+
+// Getters===========
+size_t HitBatch::size() const
+{
+  return HitBatch::from_x.size();
+}
+
+bool HitBatch::is_hit(size_t i) const
+{
+  return (HitBatch::hits[i >> 6] >> (i & 63)) & 1;
+}
+
+double HitBatch::get_time(size_t i) const
+{
+  return HitBatch::times[i];
+}
+
+bool HitBatch::get_simd() const
+{
+  return HitBatch::simd;
+}
+
+
+// Setters===========
+void HitBatch::set_simd(bool enabled)
+{
+  HitBatch::simd = enabled;
+}
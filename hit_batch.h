@@ -0,0 +1,47 @@
+#ifndef hit_batch_h
+#define hit_batch_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// @brief Batch of swept point (segment) against box tests.
+/// Tests are queued as structure of arrays, run in packets of 4 with SIMD compares
+/// and their results read back from a bitmask, with the time of impact along the segment
+class HitBatch {
+
+  // Private by default
+  // Queued tests================
+  std::vector<double> from_x = {};
+  std::vector<double> from_y = {};
+  std::vector<double> to_x = {};
+  std::vector<double> to_y = {};
+  std::vector<double> left = {};
+  std::vector<double> top = {};
+  std::vector<double> right = {};
+  std::vector<double> bottom = {};
+
+  // Results (bit i is set when test i hits)
+  std::vector<uint64_t> hits = {};
+  std::vector<double> times = {};  // in [0, 1] along the segment
+
+  bool simd = true;
+
+  public:
+    HitBatch(){}
+    void reserve(size_t tests);
+    void clear();
+    size_t add(double x0, double y0, double x1, double y1, double left, double top, double right, double bottom);
+    void run();
+
+    // getters
+    size_t size() const;
+    bool is_hit(size_t i) const;
+    double get_time(size_t i) const;
+    bool get_simd() const;
+
+    // setters
+    void set_simd(bool enabled);
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "input_log.h"
+#include <cstdio>
+#include <cstring>
+
+
+//==========================================
+// Fixed size fields (the file is little-endian, like the supported hosts)
+template <typename T>
+static bool write_field(FILE *file, T value)
+{
+  return fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+static bool read_field(FILE *file, T &value)
+{
+  return fread(&value, sizeof(T), 1, file) == 1;
+}
+
+
+/// @brief Drops every event and rewinds the replay
+void InputLog::clear()
+{
+  InputLog::events.clear();
+  InputLog::next = 0;
+}
+
+
+/// @brief Appends an event (ticks never decrease).
+/// Mouse motions within a tick are merged, only the last position matters
+/// @param event
+void InputLog::add(const InputEvent &event)
+{
+  if(
+    event.type == InputEventType::MouseMove &&
+    !InputLog::events.empty() &&
+    InputLog::events.back().type == InputEventType::MouseMove &&
+    InputLog::events.back().tick == event.tick
+  ) {
+    InputLog::events.back() = event;
+    return;
+  }
+
+  InputLog::events.push_back(event);
+}
+
+
+/// @brief Writes the log
+/// @param path
+/// @return false if the file could not be written
+bool InputLog::save(const char *path) const
+{
+  FILE *file = fopen(path, "wb");
+  if(file == nullptr) return false;
+
+  bool ok =
+    fwrite(INPUT_LOG_MAGIC, 1, 4, file) == 4 &&
+    write_field<uint32_t>(file, INPUT_LOG_VERSION) &&
+    write_field<uint64_t>(file, InputLog::seed) &&
+    write_field<double>(file, InputLog::step) &&
+    write_field<uint32_t>(file, InputLog::events.size());
+
+  for(size_t i = 0; ok && i < InputLog::events.size(); i++) {
+    const InputEvent &e = InputLog::events[i];
+    ok =
+      write_field(file, e.tick) && write_field(file, e.type) && write_field(file, e.code) &&
+      write_field(file, e.x) && write_field(file, e.y);
+  }
+
+  return fclose(file) == 0 && ok;
+}
+
+
+/// @brief Reads a log written by save() and rewinds the replay
+/// @param path
+/// @return false if the file is missing, truncated or of another version
+bool InputLog::load(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if(file == nullptr) return false;
+
+  char magic[4];
+  uint32_t version = 0, count = 0;
+  bool ok =
+    fread(magic, 1, 4, file) == 4 && !memcmp(magic, INPUT_LOG_MAGIC, 4) &&
+    read_field(file, version) && version == INPUT_LOG_VERSION &&
+    read_field(file, InputLog::seed) &&
+    read_field(file, InputLog::step) &&
+    read_field(file, count);
+
+  InputLog::clear();
+  for(uint32_t i = 0; ok && i < count; i++) {
+    InputEvent e;
+    ok =
+      read_field(file, e.tick) && read_field(file, e.type) && read_field(file, e.code) &&
+      read_field(file, e.x) && read_field(file, e.y);
+    if(ok) InputLog::events.push_back(e);
+  }
+
+  fclose(file);
+  return ok;
+}
+
+
+/// @brief Takes the next event of the replay if it is due at the given tick
+/// @param tick
+/// @param event
+/// @return false once the events up to this tick are over
+bool InputLog::next_event(uint32_t tick, InputEvent &event)
+{
+  if(InputLog::next >= InputLog::events.size() || InputLog::events[InputLog::next].tick > tick) {
+    return false;
+  }
+
+  event = InputLog::events[InputLog::next++];
+  return true;
+}
+
+
+// Getters===========
+size_t InputLog::size() const
+{
+  return InputLog::events.size();
+}
+
+uint32_t InputLog::get_last_tick() const
+{
+  return InputLog::events.empty() ? 0 : InputLog::events.back().tick;
+}
+
+uint64_t InputLog::get_seed() const
+{
+  return InputLog::seed;
+}
+
+double InputLog::get_step() const
+{
+  return InputLog::step;
+}
+
+
+// Setters===========
+void InputLog::set_run(uint64_t seed, double step)
+{
+  InputLog::seed = seed;
+  InputLog::step = step;
+}
@@ -0,0 +1,60 @@
+#ifndef input_log_h
+#define input_log_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Binary log identification
+#define INPUT_LOG_MAGIC   "TCGI"
+#define INPUT_LOG_VERSION 1
+
+enum InputEventType {
+  KeyDown,
+  KeyUp,
+  MouseDown,
+  MouseUp,
+  MouseMove
+};
+
+/// @brief Input received by a GLUT callback, applied at the start of a simulation tick
+struct InputEvent {
+  uint32_t tick;
+  uint8_t type;     // InputEventType
+  uint8_t code;     // key or mouse button
+  int16_t x;        // window coordinates
+  int16_t y;
+};
+
+/// @brief Tick stamped input events with the seed and step of the run they come from.
+/// Stored as a little-endian binary file: header (magic, version, seed, step, count)
+/// followed by 10 bytes per event
+class InputLog {
+
+  // Private by default
+  std::vector<InputEvent> events = {};
+  size_t next = 0;  // replay cursor
+  uint64_t seed = 0;
+  double step = 0;  // ms
+
+  public:
+    InputLog(){}
+    void clear();
+    void add(const InputEvent &event);
+    bool save(const char *path) const;
+    bool load(const char *path);
+
+    // replay
+    bool next_event(uint32_t tick, InputEvent &event);
+
+    // getters
+    size_t size() const;
+    uint32_t get_last_tick() const;
+    uint64_t get_seed() const;
+    double get_step() const;
+
+    // setters
+    void set_run(uint64_t seed, double step);
+};
+
+#endif
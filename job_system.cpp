@@ -0,0 +1,244 @@
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+
+// Queue owned by the calling thread (threads outside the pool use queue 0)
+static thread_local size_t current_queue = 0;
+
+
+/// @brief Starts the workers (the calling thread also runs tasks, so threads - 1 are created)
+/// @param threads total threads, 0 or 1 runs every task on the caller
+void JobSystem::setup(unsigned threads)
+{
+  JobSystem::shutdown();
+  JobSystem::stopping = false;
+
+  threads = std::max(threads, 1u);
+  JobSystem::queues.clear();
+  for(unsigned i = 0; i < threads; i++) {
+    JobSystem::queues.push_back(std::make_unique<Queue>());
+  }
+
+  current_queue = 0;
+  for(unsigned i = 1; i < threads; i++) {
+    JobSystem::workers.emplace_back(&JobSystem::worker_loop, this, i);
+  }
+}
+
+
+/// @brief Makes room in every queue for the given number of pending tasks
+/// @param tasks
+void JobSystem::reserve(size_t tasks)
+{
+  for(std::unique_ptr<Queue> &queue: JobSystem::queues) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if(queue->tasks.size() >= tasks) continue;
+
+    // Unwrapping the pending tasks into the larger ring
+    std::vector<Task> grown(tasks);
+    for(size_t i = 0; i < queue->count; i++) {
+      grown[i] = std::move(queue->tasks[(queue->head + i) % queue->tasks.size()]);
+    }
+    queue->tasks.swap(grown);
+    queue->head = 0;
+  }
+}
+
+
+/// @brief Stops and joins every worker
+void JobSystem::shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(JobSystem::sleep_mutex);
+    JobSystem::stopping = true;
+  }
+  JobSystem::wake.notify_all();
+
+  for(std::thread &worker: JobSystem::workers) {
+    worker.join();
+  }
+  JobSystem::workers.clear();
+}
+
+
+JobSystem::~JobSystem()
+{
+  JobSystem::shutdown();
+}
+
+
+//================================================
+// Appends a task to a queue (called with its mutex held), doubling a full ring
+void JobSystem::push(Queue &queue, Task task)
+{
+  if(queue.count == queue.tasks.size()) {
+    std::vector<Task> grown(std::max(queue.tasks.size() * 2, (size_t)16));
+    for(size_t i = 0; i < queue.count; i++) {
+      grown[i] = std::move(queue.tasks[(queue.head + i) % queue.tasks.size()]);
+    }
+    queue.tasks.swap(grown);
+    queue.head = 0;
+  }
+
+  queue.tasks[(queue.head + queue.count) % queue.tasks.size()] = std::move(task);
+  queue.count++;
+}
+
+
+//================================================
+// Newest task of the own queue, else the oldest task of another queue
+bool JobSystem::take(size_t index, Task &task)
+{
+  {
+    Queue &own = *JobSystem::queues[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if(own.count > 0) {
+      own.count--;
+      task = std::move(own.tasks[(own.head + own.count) % own.tasks.size()]);
+      JobSystem::queued--;
+      return true;
+    }
+  }
+
+  for(size_t i = 1; i < JobSystem::queues.size(); i++) {
+    Queue &victim = *JobSystem::queues[(index + i) % JobSystem::queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if(victim.count > 0) {
+      task = std::move(victim.tasks[victim.head]);
+      victim.head = (victim.head + 1) % victim.tasks.size();
+      victim.count--;
+      JobSystem::queued--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+//================================================
+// Runs one available task, if any
+bool JobSystem::run_one()
+{
+  Task task;
+  if(!JobSystem::take(current_queue, task)) return false;
+
+  if(JobSystem::trace != nullptr) {
+    auto begin = std::chrono::steady_clock::now();
+    task.run();
+    JobSystem::trace->record("task", "job", begin, std::chrono::steady_clock::now());
+  } else {
+    task.run();
+  }
+  task.pending->fetch_sub(1);
+  return true;
+}
+
+
+//================================================
+// Runs tasks, sleeping while every queue is empty
+void JobSystem::worker_loop(size_t index)
+{
+  current_queue = index;
+
+  while(true) {
+    if(JobSystem::run_one()) continue;
+
+    std::unique_lock<std::mutex> lock(JobSystem::sleep_mutex);
+    JobSystem::wake.wait(lock, [&] { return JobSystem::stopping || JobSystem::queued > 0; });
+    if(JobSystem::stopping) return;
+  }
+}
+
+
+/// @brief Queues a task on the calling thread's queue
+/// @param task
+/// @param pending increased now and decreased once the task has run
+void JobSystem::run(std::function<void()> task, std::atomic<size_t> &pending)
+{
+  pending.fetch_add(1);
+
+  // Without workers the caller runs it right away
+  if(JobSystem::workers.empty()) {
+    task();
+    pending.fetch_sub(1);
+    return;
+  }
+
+  {
+    Queue &own = *JobSystem::queues[current_queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    push(own, { std::move(task), &pending });
+    JobSystem::queued++;
+  }
+
+  // Taking the lock orders the push before a sleeping worker checks the queues again
+  { std::lock_guard<std::mutex> lock(JobSystem::sleep_mutex); }
+  JobSystem::wake.notify_one();
+}
+
+
+/// @brief Helps running tasks until every task counted by pending is done
+/// @param pending
+void JobSystem::wait(std::atomic<size_t> &pending)
+{
+  while(pending.load() > 0) {
+    if(!JobSystem::run_one()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+
+/// @brief Calls job(begin, end) over [0, count) split in chunks and returns once all are done.
+/// Chunk boundaries only depend on count and chunk, never on the number of threads.
+/// Chunks must not write data read by other chunks
+/// @param count number of items
+/// @param chunk items per call (at least JOB_MIN_CHUNK)
+/// @param job
+void JobSystem::parallel_for(size_t count, size_t chunk, const std::function<void(size_t, size_t)> &job)
+{
+  chunk = std::max(chunk, (size_t)JOB_MIN_CHUNK);
+
+  // Not worth a task
+  if(JobSystem::workers.empty() || count <= chunk) {
+    if(count > 0) job(0, count);
+    return;
+  }
+
+  // Tasks capture two words, which std::function stores without allocating
+  struct Range {
+    const std::function<void(size_t, size_t)> &job;
+    size_t count;
+    size_t chunk;
+  } range = { job, count, chunk };
+
+  std::atomic<size_t> pending{0};
+  for(size_t begin = chunk; begin < count; begin += chunk) {
+    JobSystem::run([&range, begin] { range.job(begin, std::min(range.count, begin + range.chunk)); }, pending);
+  }
+
+  // First chunk on the caller
+  job(0, chunk);
+  JobSystem::wait(pending);
+}
+
+
+// Getters===========
+unsigned JobSystem::get_thread_count() const
+{
+  return JobSystem::workers.size() + 1;
+}
+
+/// @brief Queue index of the calling thread (0 for threads outside the pool)
+unsigned JobSystem::get_current_thread()
+{
+  return current_queue;
+}
+
+
+// Setters===========
+void JobSystem::set_trace(TraceLog *trace)
+{
+  JobSystem::trace = trace;
+}
@@ -0,0 +1,74 @@
+#ifndef job_system_h
+#define job_system_h
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+#include "trace.h"
+
+// Smallest number of items handed to a task at once
+#define JOB_MIN_CHUNK 256
+
+/// @brief Work-stealing task scheduler over a fixed pool of threads.
+/// Each thread owns a queue: it takes its newest task first and steals the oldest tasks
+/// of the others when it runs out. Threads waiting for tasks help running them,
+/// so tasks may wait for nested tasks (e.g. a parallel_for inside a task).
+/// Queue 0 belongs to the thread that calls setup()
+class JobSystem {
+
+  // Private by default
+  struct Task {
+    std::function<void()> run;
+    std::atomic<size_t> *pending;  // decreased once run
+  };
+
+  // Ring of tasks (grown only when full, so reserve() keeps queuing allocation free)
+  struct Queue {
+    std::mutex mutex;
+    std::vector<Task> tasks;
+    size_t head = 0;   // oldest task
+    size_t count = 0;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues = {};
+  std::vector<std::thread> workers = {};
+
+  // Sleeping workers
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  std::atomic<size_t> queued{0};
+  bool stopping = false;
+
+  TraceLog *trace = nullptr;  // records the tasks run, if set
+
+  static void push(Queue &queue, Task task);
+  void worker_loop(size_t index);
+  bool take(size_t index, Task &task);
+  bool run_one();
+
+  public:
+    JobSystem(){}
+    ~JobSystem();
+    void setup(unsigned threads);
+    void reserve(size_t tasks);
+    void shutdown();
+
+    // tasks
+    void run(std::function<void()> task, std::atomic<size_t> &pending);
+    void wait(std::atomic<size_t> &pending);
+    void parallel_for(size_t count, size_t chunk, const std::function<void(size_t, size_t)> &job);
+
+    // getters
+    unsigned get_thread_count() const;
+    static unsigned get_current_thread();
+
+    // setters
+    void set_trace(TraceLog *trace);
+};
+
+#endif
@@ -0,0 +1,302 @@
+#include "level.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+//==========================================
+// Unmaps the level, if any
+Level::~Level()
+{
+  Level::close();
+}
+
+
+/// @brief Maps a compiled level and checks its header (and reads the chunk table)
+/// @param path
+/// @return false if the file is missing, truncated or of another version
+bool Level::open(const char *path)
+{
+  Level::close();
+
+  int file = ::open(path, O_RDONLY);
+  if(file < 0) return false;
+
+  struct stat info;
+  if(fstat(file, &info) != 0 || info.st_size <= 0) {
+    ::close(file);
+    return false;
+  }
+
+  void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);  // the mapping keeps the file alive
+  if(mapping == MAP_FAILED) return false;
+
+  Level::mapping = mapping;
+  Level::bytes = info.st_size;
+  Level::contents.attach(mapping, info.st_size);
+
+  // Header
+  char magic[4];
+  uint32_t version = 0;
+  uint64_t total = 0;
+  bool ok =
+    Level::contents.read(magic, 4) && !memcmp(magic, LEVEL_MAGIC, 4) &&
+    Level::contents.read(&version, sizeof(version)) && version == LEVEL_VERSION &&
+    Level::contents.read(&total, sizeof(total)) && total == Level::bytes &&
+    Level::contents.read(&(Level::chunk_width), sizeof(double));
+
+  // Chunks directory
+  if(ok && Level::chunk_width > 0) {
+    Level::contents.get(Level::bounds);
+    Level::contents.get(Level::self_spawn);
+    Level::contents.align_read(8);
+    Level::contents.get_vector(Level::chunks);
+
+    for(const LevelChunk &chunk: Level::chunks) {
+      ok = ok && chunk.offset <= Level::bytes && chunk.bytes <= Level::bytes - chunk.offset;
+    }
+    ok = ok && !Level::contents.is_overrun();
+  }
+
+  if(!ok) Level::close();
+  return ok;
+}
+
+
+/// @brief Releases the mapping
+void Level::close()
+{
+  if(Level::mapping != nullptr) {
+    munmap(Level::mapping, Level::bytes);
+  }
+  Level::mapping = nullptr;
+  Level::bytes = 0;
+  Level::contents.clear();
+  Level::chunk_width = 0;
+  Level::chunks.clear();
+}
+
+
+/// @brief Sets the arena up and appends the spawn points as svg circles
+/// (green for the player, red for enemies, like readSvg())
+/// @param arena
+/// @param circles
+/// @return false if the level is not open, is chunked or its contents are truncated or inconsistent
+bool Level::load(Arena &arena, std::vector<svg_tools::Circ> &circles)
+{
+  if(Level::mapping == nullptr || Level::is_chunked()) return false;
+
+  if(!arena.restore(Level::contents)) return false;
+
+  std::vector<LevelSpawn> spawns;
+  Level::contents.align_read(8);
+  Level::contents.get_vector(spawns);
+  if(Level::contents.is_overrun()) return false;
+
+  for(const LevelSpawn &s: spawns) {
+    if(!Level::valid_spawn(s)) return false;
+  }
+
+  circles.reserve(circles.size() + spawns.size());
+  for(const LevelSpawn &s: spawns) {
+    circles.push_back({ s.cx, s.cy, s.r, s.is_self ? "green" : "red" });
+  }
+  return true;
+}
+
+
+/// @brief Decodes a chunk of a chunked level and drops its pages from memory
+/// (safe to call from any thread while the level is open)
+/// @param i
+/// @param obstacles
+/// @param spawns enemies (red circles)
+/// @return false if the chunk is truncated or holds non-finite values (nothing is appended)
+bool Level::read_chunk(int i, std::vector<svg_tools::Rect> &obstacles, std::vector<svg_tools::Circ> &spawns) const
+{
+  const LevelChunk &chunk = Level::chunks[i];
+  const unsigned char *payload = (const unsigned char *)Level::mapping + chunk.offset;
+
+  Snapshot reader;
+  std::vector<double> bounds;
+  std::vector<LevelSpawn> enemies;
+  reader.attach(payload, chunk.bytes);
+  reader.get_vector(bounds);
+  reader.align_read(8);
+  reader.get_vector(enemies);
+
+  bool ok = !reader.is_overrun();
+  for(size_t k = 0; ok && k < bounds.size(); k++) {
+    ok = std::isfinite(bounds[k]);
+  }
+  for(const LevelSpawn &s: enemies) {
+    ok = ok && Level::valid_spawn(s);
+  }
+
+  if(ok) {
+    for(size_t k = 0; k + 4 <= bounds.size(); k += 4) {
+      obstacles.push_back({ bounds[k], bounds[k + 1], bounds[k + 2], bounds[k + 3], "black" });
+    }
+    for(const LevelSpawn &s: enemies) {
+      spawns.push_back({ s.cx, s.cy, s.r, "red" });
+    }
+  }
+
+  // The decoded copy is all that is kept (whole pages of the payload only)
+  uintptr_t page = sysconf(_SC_PAGESIZE);
+  uintptr_t first = ((uintptr_t)payload + page - 1) / page * page;
+  uintptr_t last = ((uintptr_t)payload + chunk.bytes) / page * page;
+  if(last > first) madvise((void *)first, last - first, MADV_DONTNEED);
+
+  return ok;
+}
+
+
+/// @brief Compiles an svg arena into a level file
+/// @param svg
+/// @param path
+/// @param chunk_width width of the streamed chunks (0 for a whole level)
+/// @return false if the svg is missing or the level could not be written
+bool Level::compile(char *svg, const char *path, double chunk_width)
+{
+  std::vector<svg_tools::Rect> rectangles;
+  std::vector<svg_tools::Circ> circles;
+  if(!svg_tools::loadSvg(svg, rectangles, circles)) return false;
+
+  Arena arena;
+  arena.setup(rectangles);
+
+  // Header (total size is patched once known)
+  Snapshot contents;
+  uint32_t version = LEVEL_VERSION;
+  uint64_t total = 0;
+  contents.write(LEVEL_MAGIC, 4);
+  contents.put(version);
+  contents.put(total);
+  contents.put(chunk_width);
+
+  if(chunk_width <= 0) {
+    std::vector<LevelSpawn> spawns;
+    for(const svg_tools::Circ &c: circles) {
+      spawns.push_back({ c.cx, c.cy, c.r, c.color == "green", 0 });
+    }
+
+    arena.save(contents);
+    contents.align_write(8);
+    contents.put_vector(spawns, spawns.size());
+  }
+  else {
+    // Obstacles by left edge and enemies by center, in file order within a chunk
+    int count = std::max(1, (int)std::ceil(arena.get_width() / chunk_width));
+    auto chunk_of = [&arena, chunk_width, count](double x) {
+      return std::min(std::max((int)std::floor((x - arena.get_x()) / chunk_width), 0), count - 1);
+    };
+
+    std::vector<std::vector<double>> bounds(count);
+    std::vector<std::vector<LevelSpawn>> enemies(count);
+    std::vector<LevelChunk> chunks(count);
+    LevelSpawn self_spawn = {};
+
+    for(int i = 0; i < count; i++) {
+      chunks[i].left = arena.get_x() + i * chunk_width;
+      chunks[i].reach = chunks[i].left;
+    }
+    for(const svg_tools::Rect &r: arena.get_obstacles()) {
+      int i = chunk_of(r.x);
+      bounds[i].insert(bounds[i].end(), { r.x, r.y, r.width, r.height });
+      chunks[i].reach = std::max(chunks[i].reach, r.x + r.width);
+    }
+    for(const svg_tools::Circ &c: circles) {
+      if(c.color == "green") self_spawn = { c.cx, c.cy, c.r, 1, 0 };
+      else enemies[chunk_of(c.cx)].push_back({ c.cx, c.cy, c.r, 0, 0 });
+    }
+
+    // Payloads first, in a separate buffer, so the table knows their offsets
+    double arena_bounds[4] = { arena.get_x(), arena.get_y(), arena.get_width(), arena.get_height() };
+    contents.put(arena_bounds);
+    contents.put(self_spawn);
+    contents.align_write(8);
+    size_t payloads_start = contents.size() + sizeof(size_t) + count * sizeof(LevelChunk);
+
+    Snapshot payloads;
+    for(int i = 0; i < count; i++) {
+      payloads.align_write(8);
+      chunks[i].offset = payloads_start + payloads.size();
+      payloads.put_vector(bounds[i], bounds[i].size());
+      payloads.align_write(8);
+      payloads.put_vector(enemies[i], enemies[i].size());
+      chunks[i].bytes = payloads_start + payloads.size() - chunks[i].offset;
+    }
+
+    contents.put_vector(chunks, chunks.size());
+    contents.write(payloads.data(), payloads.size());
+  }
+
+  total = contents.size();
+  FILE *file = fopen(path, "wb");
+  if(file == nullptr) return false;
+
+  bool ok =
+    fwrite(contents.data(), 1, 8, file) == 8 &&
+    fwrite(&total, sizeof(total), 1, file) == 1 &&
+    fwrite(contents.data() + 16, 1, total - 16, file) == total - 16;
+
+  return fclose(file) == 0 && ok;
+}
+
+
+//==========================================
+// Spawn points must be finite circles (corrupted ones would break the broadphase order)
+bool Level::valid_spawn(const LevelSpawn &spawn)
+{
+  return std::isfinite(spawn.cx) && std::isfinite(spawn.cy) && std::isfinite(spawn.r) && spawn.r > 0;
+}
+
+
+/// @brief Tells compiled levels from svg files by their extension
+/// @param path
+bool Level::is_level(const char *path)
+{
+  size_t length = strlen(path), extension = strlen(LEVEL_EXTENSION);
+  return length >= extension && !strcmp(path + length - extension, LEVEL_EXTENSION);
+}
+
+
+// Getters===========
+bool Level::is_chunked() const
+{
+  return Level::chunk_width > 0;
+}
+
+double Level::get_chunk_width() const
+{
+  return Level::chunk_width;
+}
+
+int Level::get_chunk_count() const
+{
+  return Level::chunks.size();
+}
+
+const LevelChunk &Level::get_chunk(int i) const
+{
+  return Level::chunks[i];
+}
+
+void Level::get_bounds(double &x, double &y, double &width, double &height) const
+{
+  x = Level::bounds[0];
+  y = Level::bounds[1];
+  width = Level::bounds[2];
+  height = Level::bounds[3];
+}
+
+svg_tools::Circ Level::get_self_spawn() const
+{
+  return { Level::self_spawn.cx, Level::self_spawn.cy, Level::self_spawn.r, "green" };
+}
@@ -0,0 +1,77 @@
+#ifndef level_h
+#define level_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "utils.h"
+#include "arena.h"
+#include "snapshot.h"
+
+// Compiled level identification (bump the version on any layout change)
+#define LEVEL_MAGIC     "TCGL"
+#define LEVEL_VERSION   2
+#define LEVEL_EXTENSION ".lvl"
+
+/// @brief Player spawn point of a compiled level
+struct LevelSpawn {
+  double cx;
+  double cy;
+  double r;
+  uint32_t is_self;
+  uint32_t padding;
+};
+
+/// @brief Vertical slice of a chunked level. It holds the obstacles whose left edge
+/// and the enemies whose center lie in [left, left + chunk width)
+struct LevelChunk {
+  double left;
+  double reach;     // rightmost obstacle edge of the chunk
+  uint64_t offset;  // payload position in the file
+  uint64_t bytes;
+};
+
+/// @brief Level compiled from an svg: header (magic, version, total bytes, chunk width)
+/// followed, for whole levels, by the arena (bounds, obstacles and both prebuilt spatial
+/// indices) and the spawn points; for chunked levels, by the bounds, the player spawn and
+/// the chunk table, each chunk payload holding its obstacles and enemy spawns.
+/// Every array is 8 bytes aligned. The file is mapped read-only and its arrays are copied
+/// out with plain memory copies, without parsing; whole levels also skip the index build.
+/// Counts and offsets are checked against the file and the obstacles before use
+class Level {
+
+  // Private by default
+  void *mapping = nullptr;
+  size_t bytes = 0;
+  Snapshot contents;  // reads the mapping in place
+
+  // Chunked levels directory
+  double chunk_width = 0;  // 0 for whole levels
+  double bounds[4] = {};   // x, y, width, height
+  LevelSpawn self_spawn = {};
+  std::vector<LevelChunk> chunks = {};
+
+  static bool valid_spawn(const LevelSpawn &spawn);
+
+  public:
+    Level(){}
+    Level(const Level &) = delete;
+    Level &operator=(const Level &) = delete;
+    ~Level();
+    bool open(const char *path);
+    void close();
+    bool load(Arena &arena, std::vector<svg_tools::Circ> &circles);
+    bool read_chunk(int i, std::vector<svg_tools::Rect> &obstacles, std::vector<svg_tools::Circ> &spawns) const;
+    static bool compile(char *svg, const char *path, double chunk_width);
+    static bool is_level(const char *path);
+
+    // getters
+    bool is_chunked() const;
+    double get_chunk_width() const;
+    int get_chunk_count() const;
+    const LevelChunk &get_chunk(int i) const;
+    void get_bounds(double &x, double &y, double &width, double &height) const;
+    svg_tools::Circ get_self_spawn() const;
+};
+
+#endif
@@ -0,0 +1,384 @@
+#include "level_stream.h"
+#include <algorithm>
+#include <cmath>
+
+
+/// @brief Starts streaming a chunked level (the arena is only set by the first load)
+/// @param level open for as long as the stream runs
+/// @param view_half_width horizontal distance from the camera to the view edges
+/// @param index spatial index of the streamed arenas
+void LevelStream::setup(const Level &level, double view_half_width, ObstacleIndex index)
+{
+  LevelStream::shutdown();
+
+  LevelStream::level = &level;
+  LevelStream::view_half_width = view_half_width;
+  LevelStream::index = index;
+  LevelStream::first = 0;
+  LevelStream::last = -1;
+
+  size_t count = level.get_chunk_count();
+  LevelStream::spawned.assign(count, 0);
+  LevelStream::waiting.assign(count, {});
+  LevelStream::parked.assign(count, {});
+  LevelStream::decoded.clear();
+  LevelStream::decoded.resize(count);
+
+  LevelStream::loads = 0;
+  LevelStream::stalls = 0;
+  LevelStream::decodes = 0;
+  LevelStream::resident_obstacles = 0;
+  LevelStream::peak_obstacles = 0;
+  LevelStream::failed_chunk = -1;
+
+  LevelStream::stopping = false;
+  LevelStream::queued = false;
+  LevelStream::building = false;
+  LevelStream::built = false;
+  LevelStream::worker = std::thread(&LevelStream::worker_loop, this);
+}
+
+
+/// @brief Stops and joins the loading thread
+void LevelStream::shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(LevelStream::mutex);
+    LevelStream::stopping = true;
+  }
+  LevelStream::wake.notify_all();
+
+  if(LevelStream::worker.joinable()) {
+    LevelStream::worker.join();
+  }
+}
+
+
+LevelStream::~LevelStream()
+{
+  LevelStream::shutdown();
+}
+
+
+//================================================
+// Builds the requested arenas until stopped
+void LevelStream::worker_loop()
+{
+  std::unique_lock<std::mutex> lock(LevelStream::mutex);
+
+  while(true) {
+    LevelStream::wake.wait(lock, [this]() { return LevelStream::stopping || LevelStream::queued; });
+    if(LevelStream::stopping) return;
+
+    LevelStream::queued = false;
+    LevelStream::building = true;
+    int first = LevelStream::request_first, last = LevelStream::request_last;
+
+    lock.unlock();
+    Resident resident;
+    LevelStream::build(first, last, resident);
+    lock.lock();
+
+    LevelStream::next = std::move(resident);
+    LevelStream::building = false;
+    LevelStream::built = true;
+    LevelStream::wake.notify_all();
+  }
+}
+
+
+//================================================
+// Drops any pending load (waits for a running one)
+void LevelStream::cancel()
+{
+  std::unique_lock<std::mutex> lock(LevelStream::mutex);
+  LevelStream::queued = false;
+  LevelStream::wake.wait(lock, [this]() { return !LevelStream::building; });
+  LevelStream::built = false;
+  LevelStream::next = Resident();
+}
+
+
+/// @brief Loads the chunks around the camera right away (setup, restore)
+/// @param center camera position
+/// @param arena replaced by the resident chunks
+/// @return false if a chunk could not be read (the arena is kept, see get_failed_chunk())
+bool LevelStream::load_now(double center, Arena &arena)
+{
+  if(!LevelStream::is_enabled()) return true;
+  LevelStream::cancel();
+
+  int first, last;
+  LevelStream::wanted(center, first, last);
+
+  Resident resident;
+  if(!LevelStream::build(std::max(first - 1, 0), std::min(last + 1, LevelStream::get_chunk_count() - 1), resident)) {
+    LevelStream::failed_chunk = resident.failed_chunk;
+    return false;
+  }
+  LevelStream::swap_in(resident, arena);
+  return true;
+}
+
+
+/// @brief Requests the chunks around the camera when it nears the edge of the resident ones
+/// (one chunk further on each side) and swaps a requested arena in when it is due.
+/// A range with an unreadable chunk is never swapped in: the resident chunks are kept
+/// and streaming stops (see get_failed_chunk())
+/// @param tick current simulation tick
+/// @param center camera position
+/// @param arena replaced by the resident chunks
+void LevelStream::update(uint32_t tick, double center, Arena &arena)
+{
+  if(!LevelStream::is_enabled() || LevelStream::failed_chunk >= 0) return;
+
+  std::unique_lock<std::mutex> lock(LevelStream::mutex);
+  bool pending = LevelStream::queued || LevelStream::building || LevelStream::built;
+
+  int first, last;
+  LevelStream::wanted(center, first, last);
+  if(!pending && (first < LevelStream::first || last > LevelStream::last)) {
+    LevelStream::request_first = std::max(first - 1, 0);
+    LevelStream::request_last = std::min(last + 1, LevelStream::get_chunk_count() - 1);
+    LevelStream::due_tick = tick + LEVEL_STREAM_DELAY;
+    LevelStream::queued = true;
+    LevelStream::wake.notify_all();
+    return;
+  }
+
+  if(pending && tick >= LevelStream::due_tick) {
+    if(!LevelStream::built) {
+      LevelStream::stalls++;  // load slower than the delay
+      LevelStream::wake.wait(lock, [this]() { return LevelStream::built; });
+    }
+    LevelStream::built = false;
+    if(LevelStream::next.failed_chunk >= 0) {
+      LevelStream::failed_chunk = LevelStream::next.failed_chunk;
+    } else {
+      LevelStream::swap_in(LevelStream::next, arena);
+    }
+    LevelStream::next = Resident();
+  }
+}
+
+
+//================================================
+// Assembles chunks [first, last] (and the obstacles of earlier chunks reaching into them).
+// Only chunks not kept from the previous builds are decoded and indexed; the others are released.
+// Returns false, with out.failed_chunk set and no arena, if a chunk cannot be read
+bool LevelStream::build(int first, int last, Resident &out)
+{
+  const Level &level = *LevelStream::level;
+  double left = level.get_chunk(first).left;
+
+  double x, y, width, height;
+  level.get_bounds(x, y, width, height);
+
+  std::vector<const Arena *> pieces;
+  for(int j = 0; j < LevelStream::get_chunk_count(); j++) {
+    DecodedChunk &chunk = LevelStream::decoded[j];
+
+    bool needed = j <= last && (j >= first || level.get_chunk(j).reach > left);
+    if(!needed) {
+      if(chunk.ready) chunk = DecodedChunk();
+      continue;
+    }
+
+    if(!chunk.ready) {
+      std::vector<svg_tools::Rect> obstacles;
+      if(!level.read_chunk(j, obstacles, chunk.spawns)) {
+        out.failed_chunk = j;
+        return false;
+      }
+      chunk.arena.set_index(LevelStream::index);
+      chunk.arena.setup(x, y, width, height, std::move(obstacles));
+      chunk.ready = true;
+      LevelStream::decodes++;
+    }
+    pieces.push_back(&chunk.arena);
+
+    // Spawns of chunks left of the range are never needed
+    if(j >= first) {
+      out.spawns.insert(out.spawns.end(), chunk.spawns.begin(), chunk.spawns.end());
+      out.spawn_chunks.resize(out.spawns.size(), j);
+    }
+  }
+
+  out.first = first;
+  out.last = last;
+  out.arena.set_index(LevelStream::index);
+  out.arena.assemble(x, y, width, height, pieces);
+  return true;
+}
+
+
+//================================================
+// Makes a built range the resident one
+void LevelStream::swap_in(Resident &resident, Arena &arena)
+{
+  // Spawns of newly resident chunks wait for their chunk to be active
+  for(size_t k = 0; k < resident.spawns.size(); k++) {
+    int j = resident.spawn_chunks[k];
+    bool was_resident = j >= LevelStream::first && j <= LevelStream::last;
+    if(!was_resident && !LevelStream::spawned[j]) {
+      LevelStream::waiting[j].push_back(resident.spawns[k]);
+    }
+  }
+
+  // Evicted chunks keep only their parked enemies
+  for(int j = LevelStream::first; j <= LevelStream::last; j++) {
+    if(j < resident.first || j > resident.last) {
+      std::vector<svg_tools::Circ>().swap(LevelStream::waiting[j]);
+    }
+  }
+
+  std::swap(arena, resident.arena);
+  LevelStream::first = resident.first;
+  LevelStream::last = resident.last;
+
+  LevelStream::loads++;
+  LevelStream::resident_obstacles = arena.get_obstacles().size();
+  LevelStream::peak_obstacles = std::max(LevelStream::peak_obstacles, LevelStream::resident_obstacles);
+}
+
+
+//================================================
+// Chunks covering the view plus the stream radius
+void LevelStream::wanted(double center, int &first, int &last) const
+{
+  first = std::max(LevelStream::chunk_of(center - LevelStream::view_half_width) - LEVEL_STREAM_RADIUS, 0);
+  last = std::min(
+    LevelStream::chunk_of(center + LevelStream::view_half_width) + LEVEL_STREAM_RADIUS,
+    LevelStream::get_chunk_count() - 1
+  );
+}
+
+
+//================================================
+// Chunk containing x (clamped to the level)
+int LevelStream::chunk_of(double x) const
+{
+  double origin = LevelStream::level->get_chunk(0).left;
+  int j = (int)std::floor((x - origin) / LevelStream::level->get_chunk_width());
+  return std::min(std::max(j, 0), LevelStream::get_chunk_count() - 1);
+}
+
+
+/// @brief Tells if an enemy at x moves (its chunk and the neighbours are resident)
+/// @param x 
+bool LevelStream::is_active(double x) const
+{
+  if(!LevelStream::is_enabled()) return true;
+
+  int j = LevelStream::chunk_of(x);
+  int first = (LevelStream::first == 0) ? 0 : LevelStream::first + 1;
+  int last = (LevelStream::last == LevelStream::get_chunk_count() - 1) ? LevelStream::last : LevelStream::last - 1;
+  return j >= first && j <= last;
+}
+
+
+/// @brief Keeps an enemy out of an inactive chunk until it is active again
+/// @param enemy 
+void LevelStream::park(const Player &enemy)
+{
+  LevelStream::parked[LevelStream::chunk_of(enemy.get_cx())].push_back(enemy);
+}
+
+
+/// @brief Appends the parked enemies and the first spawns of the active chunks
+/// @param enemies parked enemies, as they were left
+/// @param spawns enemies never spawned before
+void LevelStream::take_arrivals(std::vector<Player> &enemies, std::vector<svg_tools::Circ> &spawns)
+{
+  if(!LevelStream::is_enabled()) return;
+
+  int first = (LevelStream::first == 0) ? 0 : LevelStream::first + 1;
+  int last = (LevelStream::last == LevelStream::get_chunk_count() - 1) ? LevelStream::last : LevelStream::last - 1;
+
+  for(int j = first; j <= last; j++) {
+    std::vector<Player> &chunk_parked = LevelStream::parked[j];
+    enemies.insert(enemies.end(), chunk_parked.begin(), chunk_parked.end());
+    chunk_parked.clear();
+
+    if(!LevelStream::spawned[j]) {
+      spawns.insert(spawns.end(), LevelStream::waiting[j].begin(), LevelStream::waiting[j].end());
+      std::vector<svg_tools::Circ>().swap(LevelStream::waiting[j]);
+      LevelStream::spawned[j] = 1;
+    }
+  }
+}
+
+
+/// @brief Writes which chunks spawned their enemies and the parked enemies
+/// @param snapshot
+void LevelStream::save(Snapshot &snapshot) const
+{
+  snapshot.put_vector(LevelStream::spawned, LevelStream::spawned.size());
+  for(const std::vector<Player> &chunk_parked: LevelStream::parked) {
+    snapshot.put_vector(chunk_parked, chunk_parked.size());
+  }
+}
+
+
+/// @brief Reads what save() wrote. The resident chunks are unknown until load_now()
+/// @param snapshot
+void LevelStream::restore(Snapshot &snapshot)
+{
+  snapshot.get_vector(LevelStream::spawned);
+  LevelStream::parked.resize(LevelStream::spawned.size());
+  for(std::vector<Player> &chunk_parked: LevelStream::parked) {
+    snapshot.get_vector(chunk_parked);
+  }
+
+  LevelStream::waiting.assign(LevelStream::spawned.size(), {});
+  LevelStream::first = 0;
+  LevelStream::last = -1;
+}
+
+
+// Getters===========
+bool LevelStream::is_enabled() const
+{
+  return LevelStream::level != nullptr && LevelStream::level->is_chunked();
+}
+
+int LevelStream::get_chunk_count() const
+{
+  return LevelStream::is_enabled() ? LevelStream::level->get_chunk_count() : 0;
+}
+
+int LevelStream::get_resident_count() const
+{
+  return std::max(LevelStream::last - LevelStream::first + 1, 0);
+}
+
+size_t LevelStream::get_resident_obstacles() const
+{
+  return LevelStream::resident_obstacles;
+}
+
+size_t LevelStream::get_peak_obstacles() const
+{
+  return LevelStream::peak_obstacles;
+}
+
+size_t LevelStream::get_loads() const
+{
+  return LevelStream::loads;
+}
+
+size_t LevelStream::get_stalls() const
+{
+  return LevelStream::stalls;
+}
+
+size_t LevelStream::get_decodes() const
+{
+  return LevelStream::decodes;
+}
+
+/// @brief Chunk that could not be read, or -1
+int LevelStream::get_failed_chunk() const
+{
+  return LevelStream::failed_chunk;
+}
@@ -0,0 +1,116 @@
+#ifndef level_stream_h
+#define level_stream_h
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "level.h"
+#include "arena.h"
+#include "player.h"
+#include "snapshot.h"
+
+// Chunks kept resident beyond the view on each side
+#define LEVEL_STREAM_RADIUS 1
+
+// Ticks between a load request and the swap of its arena. The swap tick only depends on
+// the simulation, so runs stay reproducible; the main thread waits only for late loads
+#define LEVEL_STREAM_DELAY  30
+
+/// @brief Streams the chunks of a chunked level around the camera.
+/// A background thread decodes the chunks entering the range, indexes each of them on its
+/// own and assembles the arena of the range from them (chunks staying resident are neither
+/// decoded nor indexed again); the arena replaces the current one at a tick boundary. Enemies only move in
+/// active chunks (resident with resident neighbours): the others are parked with their state
+/// and come back when their chunk is active again, enemies of never visited chunks spawn then
+class LevelStream {
+
+  // Arena of a range of chunks, built off the main thread
+  struct Resident {
+    int first = 0;
+    int last = -1;
+    Arena arena;
+    std::vector<int> spawn_chunks = {};  // chunk of each spawn
+    std::vector<svg_tools::Circ> spawns = {};
+    int failed_chunk = -1;               // chunk that could not be read (nothing to swap in)
+  };
+
+  // Chunk decoded and indexed once, kept while it is part of the built ranges
+  struct DecodedChunk {
+    bool ready = false;
+    Arena arena;
+    std::vector<svg_tools::Circ> spawns = {};
+  };
+
+  // Private by default
+  const Level *level = nullptr;
+  double view_half_width = 0;
+  ObstacleIndex index = ObstacleIndex::UniformGrid;
+  int first = 0;   // resident chunks
+  int last = -1;
+
+  // Decoded chunks (only touched by whoever builds: the worker, or load_now() once it is idle)
+  std::vector<DecodedChunk> decoded = {};
+
+  // Enemies by chunk
+  std::vector<uint8_t> spawned = {};
+  std::vector<std::vector<svg_tools::Circ>> waiting = {};  // spawns of resident chunks
+  std::vector<std::vector<Player>> parked = {};
+
+  // Background loads
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+  bool queued = false;      // a load waits for the worker
+  bool building = false;    // the worker owns next
+  bool built = false;       // next is ready to be swapped in
+  int request_first = 0;
+  int request_last = -1;
+  uint32_t due_tick = 0;
+  Resident next;
+
+  // Statistics
+  size_t loads = 0;
+  size_t stalls = 0;
+  std::atomic<size_t> decodes{0};  // chunks decoded and indexed (counted by the builder)
+  size_t resident_obstacles = 0;
+  size_t peak_obstacles = 0;
+  int failed_chunk = -1;  // first chunk that could not be read (streaming stops)
+
+  void worker_loop();
+  bool build(int first, int last, Resident &out);
+  void swap_in(Resident &resident, Arena &arena);
+  void cancel();
+  void wanted(double center, int &first, int &last) const;
+  int chunk_of(double x) const;
+
+  public:
+    LevelStream(){}
+    ~LevelStream();
+    void setup(const Level &level, double view_half_width, ObstacleIndex index);
+    void shutdown();
+    bool load_now(double center, Arena &arena);
+    void update(uint32_t tick, double center, Arena &arena);
+    bool is_active(double x) const;
+    void park(const Player &enemy);
+    void take_arrivals(std::vector<Player> &enemies, std::vector<svg_tools::Circ> &spawns);
+    void save(Snapshot &snapshot) const;
+    void restore(Snapshot &snapshot);
+
+    // getters
+    bool is_enabled() const;
+    int get_chunk_count() const;
+    int get_resident_count() const;
+    size_t get_resident_obstacles() const;
+    size_t get_peak_obstacles() const;
+    size_t get_loads() const;
+    size_t get_stalls() const;
+    size_t get_decodes() const;
+    int get_failed_chunk() const;
+};
+
+#endif
@@ -6,14 +6,31 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <list>
 #include <random>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 #include "tinyxml2.h"
 #include "player.h"
 #include "utils.h"
 #include "arena.h"
 #include "shot.h"
+#include "shot_pool.h"
+#include "broadphase.h"
+#include "collision.h"
+#include "hit_batch.h"
+#include "job_system.h"
+#include "pipeline.h"
+#include "rng.h"
+#include "input_log.h"
+#include "snapshot.h"
+#include "level.h"
+#include "level_stream.h"
+#include "profiler.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "alloc_tracker.h"
 
 #define GRAVITY           28
 #define MOUSE_LEFT        254
@@ -22,6 +39,16 @@
 #define PRINT_BASE_Y      145
 #define SHOT_INTERVAL     1000 // ms
 #define ENEMIES_VELOCITY  0.02
+#define HEADLESS_TICKS    10000
+#define SIM_HZ            120
+#define MAX_FRAME_TIME    250.0 // ms, avoids spiral of death after stalls
+#define ENEMY_CHUNK       1024  // enemies per job
+#define SHOT_CHUNK        8192  // shots per job
+#define SHOT_CANDIDATES   2     // players reserved per shot (crowds beyond it allocate)
+#define SHOT_HIT_TESTS    4     // hit tests reserved per shot (players and obstacles)
+#define PROFILER_REFRESH  30    // frames between updates of the profiler table
+#define PROFILER_MARGIN   5     // pixels
+#define PROFILER_LINE     15    // pixels (height of the bitmap font)
 
 
 // End game control
@@ -32,6 +59,15 @@ int camera_reset = 0;
 bool win = false;
 char *svg;
 
+// Camera horizontal translation (applied to the projection at render time)
+double camera_offset = 0.0;
+double previous_camera_offset = 0.0;
+
+// Fixed timestep
+double sim_step = 1000.0 / SIM_HZ;  // ms
+double sim_accumulator = 0.0;
+double render_alpha = 1.0;          // interpolation between last two states
+
 // Window dimensions
 const int Width = 500;
 const int Height = 500;
@@ -46,6 +82,7 @@ FallState fall_state = FallState::NotFalling;
 // Enemy controls
 double shot_timer = 0.0;
 double enemy_change_walk_timer = 0.0;
+uint32_t next_enemy_id = 0;  // ids in spawn order
 
 // Callback declarations
 void init(void);
@@ -59,19 +96,43 @@ void mouseClick(int button, int state, int x, int y);
 
 // utilities
 double get_time_diff();
+void update(double timeDifference);
+void queue_input(InputEventType type, int code, int x, int y);
+void apply_input();
+void apply_input_event(const InputEvent &event);
+void save_recording();
+bool parse_positive(const char *text, double &value);
+void save_trace();
+void setup_counters();
+void print_counters();
+void count_tick_allocations(const AllocStats &before, const AllocStats &after);
+void print_allocations();
+void setup_profiler();
+void update_profiler_table();
+void draw_profiler();
+void setup_pipeline();
+void stream_level();
+void check_level_stream();
+double camera_center();
+void move_self(double timeDifference);
+void find_candidates();
+void resolve_hits();
+void move_enemies(double timeDifference);
+void fire_enemies(double timeDifference);
+void check_win();
+void store_previous_state();
+void run_headless(long ticks, long bullet_hell);
+void spawn_bullet_hell(long target, RngStream &rng);
 void setup(char * file);
+void reserve_tick_storage();
+void save_world(Snapshot &snapshot);
+void restore_world(Snapshot &snapshot);
+void add_shot(const Shot &shot);
+void update_broadphase();
 void reset_camera(double displacement);
 void print_message(double x, double y, char * message);
 void set_camera(double time, double velocity, HorizontalMoveDirection direction);
 
-// game_tools
-bool is_player_into_arena_horizontally(Player player, Arena arena, HorizontalMoveDirection direction);
-bool walking_collision(Player &player, Arena arena, std::list<Player> enemies, HorizontalMoveDirection direction, double timeDiff);
-bool jumping_collision(Player &player, Arena arena, std::list<Player> enemies, double timeDiff);
-bool falling_collision(Player &player, Arena arena, std::list<Player> enemies, double timeDiff);
-bool platform_end_detected(Player player, Arena arena);
-bool players_collision(Player p1, Player p2); 
-
 //svg data===================================
 std::vector<svg_tools::Rect> rectangles = {};
 std::vector<svg_tools::Circ> circles = {};
@@ -79,8 +140,98 @@ std::vector<svg_tools::Circ> circles = {};
 // Game components
 Arena ring;
 Player self;
-std::list<Shot*> shots;
-std::list<Player> enemies;
+ShotPool shots;  // live shots in creation order
+std::vector<Player> enemies;
+CollisionWorld world;  // collision queries over ring and enemies
+JobSystem jobs;        // worker threads for data-parallel updates
+Rng rng;               // every random number of a run comes from its seed
+
+// Input applied at tick boundaries, optionally recorded or replayed
+std::vector<InputEvent> pending_input;
+InputLog input_log;
+uint32_t sim_tick = 0;
+bool recording = false;
+bool replaying = false;
+const char *record_path = nullptr;
+
+// Compiled level (kept open while its chunks are streamed)
+Level level;
+LevelStream level_stream;
+std::vector<Player> arrivals;                 // enemies entering active chunks
+std::vector<svg_tools::Circ> arrival_spawns;
+
+// World right after setup (restart restores it instead of reloading the svg)
+Snapshot initial_world;
+double setup_time = 0;  // level loading (ms)
+
+// Tick stages and the state they touch
+enum TickState {
+  InputState      = 1 << 0,
+  ArenaState      = 1 << 1,
+  SelfState       = 1 << 2,
+  EnemyState      = 1 << 3,
+  ShotState       = 1 << 4,
+  BroadphaseState = 1 << 5,
+  CameraState     = 1 << 6,
+  GameState       = 1 << 7
+};
+Pipeline tick_pipeline;
+double tick_time = 0;  // step of the running tick (ms)
+
+// Frame profiler sections (tick stage i is section TickSections + i)
+enum FrameSection {
+  FrameTotal,
+  InputSection,
+  PreviousStateSection,
+  DrawArenaSection,
+  DrawPlayersSection,
+  DrawShotsSection,
+  SwapSection,
+  TickSections
+};
+FrameProfiler profiler;
+bool show_profiler = false;             // table on screen ('p' or --profile)
+std::vector<std::string> profiler_table;
+long profiler_frames = 0;
+std::chrono::steady_clock::time_point frame_end = std::chrono::steady_clock::now();
+
+// Timeline of the latest ticks, stages and worker tasks (--trace)
+TraceLog trace;
+const char *trace_path = nullptr;
+
+// Hardware counters around the tick stages (--counters)
+bool counting = false;
+bool counter_available[PerfCounterCount] = {};
+int counter_error = 0;
+
+// Heap activity of the ticks (profiling builds, see alloc_tracker.h)
+AllocStats tick_allocations = {};  // summed over every tick
+uint64_t max_tick_allocations = 0;
+long allocating_ticks = 0;
+long last_allocating_tick = -1;
+long no_alloc_after = -1;          // --assert-no-alloc: later ticks must not allocate
+long first_late_tick = -1;         // first tick breaking it
+
+// Broadphase among players and shots
+SweepAndPrune broadphase;
+std::vector<ProxyPair> pairs;
+std::vector<ProxyPair> shot_candidates;  // (shot, enemy) indices; self is enemies.size()
+std::vector<char> enemy_near_self;
+std::vector<int> nearby_players;         // players around one shot
+
+// Obstacles whose box the motion of a shot touches: worker_obstacles[thread][first, first + count)
+struct ShotObstacles {
+  unsigned thread;
+  size_t first;
+  size_t count;
+};
+
+// Per tick scratch buffers (reused, no allocation in steady state)
+std::vector<std::vector<int>> worker_obstacles;  // obstacles touched by shots, per job system thread
+std::vector<ShotObstacles> shot_obstacles;       // of each shot
+std::vector<char> enemy_dead;
+HitBatch hit_tests;                  // shot against players and obstacles, run as one batch
+std::vector<size_t> obstacle_tests;  // first obstacle test of each shot
 
 
 //=============================//
@@ -94,9 +245,150 @@ int main(int argc, char *argv[])
     exit(1);
   }
 
+  // Optional flags
+  bool headless = false;
+  long headless_ticks = HEADLESS_TICKS;
+  long shot_capacity = SHOT_POOL_CAPACITY;
+  long bullet_hell = 0;
+  long threads = std::thread::hardware_concurrency();
+  uint64_t seed = std::random_device()();  // fresh runs unless --seed is given
+  bool ticks_given = false;
+  const char *replay_path = nullptr;
+  long trace_events = TRACE_CAPACITY;
+
+  for(int i = 2; i < argc; i++){
+    if(!strcmp(argv[i], "--headless")){
+      headless = true;
+    }
+    else if(!strcmp(argv[i], "--ticks") and i + 1 < argc){
+      headless_ticks = atol(argv[++i]);
+      ticks_given = true;
+    }
+    else if(!strcmp(argv[i], "--index") and i + 1 < argc){
+      i++;
+      if(!strcmp(argv[i], "brute")) ring.set_index(ObstacleIndex::BruteForce);
+      else if(!strcmp(argv[i], "grid")) ring.set_index(ObstacleIndex::UniformGrid);
+      else if(!strcmp(argv[i], "bvh")) ring.set_index(ObstacleIndex::BoundingVolumeHierarchy);
+      else {
+        std::cerr << "Unknown index: " << argv[i] << " (brute, grid or bvh)" << std::endl;
+        exit(1);
+      }
+    }
+    else if(!strcmp(argv[i], "--shots") and i + 1 < argc){
+      shot_capacity = atol(argv[++i]);
+    }
+    else if(!strcmp(argv[i], "--bullet-hell") and i + 1 < argc){
+      bullet_hell = atol(argv[++i]);
+    }
+    else if(!strcmp(argv[i], "--no-simd")){
+      shots.set_simd(false);
+      hit_tests.set_simd(false);
+    }
+    else if(!strcmp(argv[i], "--record") and i + 1 < argc){
+      record_path = argv[++i];
+      recording = true;
+    }
+    else if(!strcmp(argv[i], "--replay") and i + 1 < argc){
+      replay_path = argv[++i];
+      replaying = true;
+    }
+    else if(!strcmp(argv[i], "--seed") and i + 1 < argc){
+      seed = strtoull(argv[++i], nullptr, 10);
+    }
+    else if(!strcmp(argv[i], "--threads") and i + 1 < argc){
+      threads = atol(argv[++i]);
+    }
+    else if((!strcmp(argv[i], "--hz") or !strcmp(argv[i], "--dt")) and i + 1 < argc){
+      double value;
+      bool valid = parse_positive(argv[i + 1], value);
+      if(valid and !strcmp(argv[i], "--hz")){
+        value = 1000.0 / value;
+        valid = std::isfinite(value);  // rates too small for a step
+      }
+      if(!valid){
+        std::cerr << "Invalid " << argv[i] << ": " << argv[i + 1] << " (positive number)" << std::endl;
+        exit(1);
+      }
+      sim_step = value;
+      i++;
+    }
+    else if(!strcmp(argv[i], "--profile")){
+      show_profiler = true;
+    }
+    else if(!strcmp(argv[i], "--trace") and i + 1 < argc){
+      trace_path = argv[++i];
+    }
+    else if(!strcmp(argv[i], "--trace-events") and i + 1 < argc){
+      trace_events = atol(argv[++i]);
+    }
+    else if(!strcmp(argv[i], "--counters")){
+      counting = true;
+    }
+    else if(!strcmp(argv[i], "--assert-no-alloc") and i + 1 < argc){
+      no_alloc_after = atol(argv[++i]);
+    }
+    else {
+      std::cerr << "Unknown option: " << argv[i] << std::endl;
+      exit(1);
+    }
+  }
+
+  if(no_alloc_after >= 0 and !(headless and AllocTracker::is_enabled())){
+    std::cerr << "--assert-no-alloc needs --headless and a profiling build (make profile)" << std::endl;
+    exit(1);
+  }
+
+  // A replay runs with the seed and step it was recorded with
+  if(replaying){
+    if(!input_log.load(replay_path)){
+      std::cerr << "Invalid input log: " << replay_path << std::endl;
+      exit(1);
+    }
+    seed = input_log.get_seed();
+    sim_step = input_log.get_step();
+    if(!(sim_step > 0 and std::isfinite(sim_step))){
+      std::cerr << "Invalid input log: " << replay_path << " (step " << sim_step << " ms)" << std::endl;
+      exit(1);
+    }
+    if(!ticks_given) headless_ticks = input_log.get_last_tick() + 1;
+  }
+  if(recording){
+    input_log.set_run(seed, sim_step);
+    atexit(save_recording);
+  }
+
+  jobs.setup(std::max(threads, 1L));
+  worker_obstacles.resize(jobs.get_thread_count());
+  rng.set_seed(seed);
+  setup_pipeline();
+  setup_profiler();
+  if(counting){
+    setup_counters();
+  }
+
+  // Trace written at exit (also when leaving with ESC)
+  if(trace_path){
+    trace.setup(std::max(trace_events, 1L), jobs.get_thread_count());
+    jobs.set_trace(&trace);
+    tick_pipeline.set_trace(&trace);
+    atexit(save_trace);
+  }
+
+  // Shots storage is allocated once
+  shots.setup(std::max(shot_capacity, bullet_hell));
+
   // Saving svg file globally
   svg = argv[1];
+  auto setup_start = std::chrono::steady_clock::now();
   setup(svg);
+  setup_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setup_start).count();
+  save_world(initial_world);
+
+  // Simulation without window (no GLUT calls)
+  if(headless){
+    run_headless(headless_ticks, bullet_hell);
+    return 0;
+  }
 
   // Setting up GLUT===================
   glutInit(&argc, argv);
@@ -137,12 +429,47 @@ void setup(char * file){
   circles.clear();
   enemies.clear();
   shots.clear();
+  broadphase.clear();
 
   // Reading .svg and setting up ring==============
-  svg_tools::readSvg(file, rectangles, circles);  //vectors passed by referece   
-  ring.setup(rectangles);
+  // (compiled levels are mapped with the spatial index prebuilt, no parsing)
+  // (chunked levels start empty, their chunks are streamed around the camera)
+  if(Level::is_level(file)){
+    if(!level.open(file)){
+      std::cerr << "Invalid level: " << file << std::endl;
+      exit(1);
+    }
+    if(level.is_chunked()){
+      double x, y, width, height;
+      level.get_bounds(x, y, width, height);
+      ring.setup(x, y, width, height, {});
+      circles.push_back(level.get_self_spawn());
+    }
+    else if(!level.load(ring, circles)){
+      std::cerr << "Invalid level: " << file << std::endl;
+      exit(1);
+    }
+    else {
+      level.close();
+    }
+  } else {
+    if(!svg_tools::loadSvg(file, rectangles, circles)){  //vectors passed by referece   
+      std::cerr << "Invalid svg: " << file << std::endl;
+      exit(1);
+    }
+    ring.setup(rectangles);
+  }
+  world.setup(ring, enemies);
+
+  // Shots expire a view width (the arena height) beyond the arena, whatever its size
+  double shot_margin = ring.get_height();
+  shots.set_bounds(
+    ring.get_x() - shot_margin, ring.get_y() - shot_margin,
+    ring.get_x() + ring.get_width() + shot_margin, ring.get_y() + ring.get_height() + shot_margin
+  );
   
   // Setting up players===================
+  next_enemy_id = 0;
   for(const svg_tools::Circ &c: circles){
     if(c.color == "green"){
       self.setup(c);
@@ -151,8 +478,209 @@ void setup(char * file){
     Player p;
     p.setup(c);
     p.set_velocity(ENEMIES_VELOCITY);
+    p.set_id(next_enemy_id++);
     enemies.push_back(p); // copying instance into global vector
   }
+
+  // Registering players in the broadphase
+  self.set_proxy(broadphase.create_proxy(
+    ProxyKind::SelfProxy, 0, self.get_left_edge(), self.get_right_edge(), self.get_top_edge(), self.get_bottom_edge()
+  ));
+  for(size_t i = 0; i < enemies.size(); i++) {
+    Player &p = enemies[i];
+    p.set_proxy(broadphase.create_proxy(
+      ProxyKind::EnemyProxy, i, p.get_left_edge(), p.get_right_edge(), p.get_top_edge(), p.get_bottom_edge()
+    ));
+  }
+
+  // First chunks of a streamed level
+  if(level.is_chunked()){
+    level_stream.setup(level, ring.get_height() / 2, ring.get_index());
+    level_stream.load_now(camera_center(), ring);
+    check_level_stream();
+    stream_level();
+  }
+
+  reserve_tick_storage();
+}
+
+
+//======================================================
+// Sizes every buffer reused by the ticks from the shot pool capacity, the players
+// and the obstacles, so the steady state does not allocate
+void reserve_tick_storage(){
+  size_t shot_capacity = shots.get_capacity();
+  size_t players = enemies.size() + 1;
+  size_t obstacles = ring.get_obstacles().size();
+
+  // Broadphase and narrow phase
+  broadphase.reserve(players);
+  pairs.reserve(players);
+  enemy_near_self.reserve(players);
+  nearby_players.reserve(players);
+  shot_candidates.reserve(shot_capacity * SHOT_CANDIDATES);
+  hit_tests.reserve(shot_capacity * SHOT_HIT_TESTS);
+
+  // Shots against obstacles (a thread may run every shot: room for their obstacles
+  // plus the unfiltered candidates of one query)
+  for(std::vector<int> &touched: worker_obstacles) {
+    touched.reserve(shot_capacity * SHOT_HIT_TESTS + obstacles);
+  }
+  shot_obstacles.reserve(shot_capacity);
+  obstacle_tests.reserve(shot_capacity + 1);
+  enemy_dead.reserve(players);
+
+  // Players against the arena, and the tasks of the parallel stages
+  world.reserve(players, obstacles, jobs.get_thread_count());
+  jobs.reserve(tick_pipeline.get_stage_count() + shot_capacity / SHOT_CHUNK + players / ENEMY_CHUNK + 2);
+}
+
+
+//======================================================
+// A chunk that cannot be read is reported like a level that cannot be opened
+// (the stream keeps its resident chunks and never swaps the bad range in)
+void check_level_stream(){
+  if(level_stream.get_failed_chunk() < 0) return;
+  std::cerr << "Invalid level: " << svg << " (chunk " << level_stream.get_failed_chunk() << ")" << std::endl;
+  exit(1);
+}
+
+
+//======================================================
+// Swaps streamed chunks in and moves enemies between
+// the active chunks and the parked ones
+void stream_level(){
+  if(!level_stream.is_enabled()) return;
+
+  level_stream.update(sim_tick, camera_center(), ring);
+
+  // Parking enemies out of the active chunks (keeping order)
+  size_t kept = 0;
+  for(size_t i = 0; i < enemies.size(); i++) {
+    if(!level_stream.is_active(enemies[i].get_cx())) {
+      broadphase.destroy_proxy(enemies[i].get_proxy());
+      level_stream.park(enemies[i]);
+      continue;
+    }
+    enemies[kept++] = enemies[i];
+  }
+  enemies.resize(kept);
+
+  // Enemies of chunks that became active
+  arrivals.clear();
+  arrival_spawns.clear();
+  level_stream.take_arrivals(arrivals, arrival_spawns);
+  for(const svg_tools::Circ &c: arrival_spawns){
+    Player p;
+    p.setup(c);
+    p.set_velocity(ENEMIES_VELOCITY);
+    p.set_id(next_enemy_id++);
+    arrivals.push_back(p);
+  }
+  for(Player &p: arrivals){
+    p.set_proxy(broadphase.create_proxy(
+      ProxyKind::EnemyProxy, enemies.size(), p.get_left_edge(), p.get_right_edge(), p.get_top_edge(), p.get_bottom_edge()
+    ));
+    enemies.push_back(p);
+  }
+}
+
+
+//==========================================
+// Arena position at the center of the view
+double camera_center(){
+  return self.get_initial_cx() - camera_offset;
+}
+
+
+//======================================================
+// Copies the simulation state into a snapshot
+// (the arena never changes after setup, so it is left out)
+void save_world(Snapshot &snapshot){
+  snapshot.clear();
+
+  snapshot.put(self);
+  snapshot.put_vector(enemies, enemies.size());
+  level_stream.save(snapshot);
+  shots.save(snapshot);
+
+  snapshot.put(jump_state);
+  snapshot.put(fall_state);
+  snapshot.put(shot_timer);
+  snapshot.put(enemy_change_walk_timer);
+  snapshot.put(next_enemy_id);
+  snapshot.put(camera_offset);
+  snapshot.put(previous_camera_offset);
+  snapshot.put(camera_reset);
+  snapshot.put(game_over);
+  snapshot.put(win);
+}
+
+
+//======================================================
+// Puts the simulation back in a saved state
+// and registers its players and shots in a fresh broadphase
+void restore_world(Snapshot &snapshot){
+  snapshot.rewind();
+
+  snapshot.get(self);
+  snapshot.get_vector(enemies);
+  level_stream.restore(snapshot);
+  if(!shots.restore(snapshot)) {
+    std::cerr << "Snapshot shots do not fit the pool (capacity " << shots.get_capacity() << "), shots dropped" << std::endl;
+  }
+
+  snapshot.get(jump_state);
+  snapshot.get(fall_state);
+  snapshot.get(shot_timer);
+  snapshot.get(enemy_change_walk_timer);
+  snapshot.get(next_enemy_id);
+  snapshot.get(camera_offset);
+  snapshot.get(previous_camera_offset);
+  snapshot.get(camera_reset);
+  snapshot.get(game_over);
+  snapshot.get(win);
+
+  // Streamed chunks around the restored camera
+  level_stream.load_now(camera_center(), ring);
+  check_level_stream();
+
+  // Proxy ids are only valid in the broadphase they came from
+  broadphase.clear();
+  self.set_proxy(broadphase.create_proxy(
+    ProxyKind::SelfProxy, 0, self.get_left_edge(), self.get_right_edge(), self.get_top_edge(), self.get_bottom_edge()
+  ));
+  for(size_t i = 0; i < enemies.size(); i++) {
+    Player &p = enemies[i];
+    p.set_proxy(broadphase.create_proxy(
+      ProxyKind::EnemyProxy, i, p.get_left_edge(), p.get_right_edge(), p.get_top_edge(), p.get_bottom_edge()
+    ));
+  }
+}
+
+
+//======================================
+// Adds a shot to the world
+void add_shot(const Shot &shot){
+  shots.spawn(shot);  // dropped if the pool is full
+}
+
+
+//============================================================
+// Moves players' broadphase boxes to current positions and indices
+void update_broadphase(){
+  broadphase.move_proxy(
+    self.get_proxy(), 0, self.get_left_edge(), self.get_right_edge(), self.get_top_edge(), self.get_bottom_edge()
+  );
+
+  for(size_t i = 0; i < enemies.size(); i++) {
+    const Player &p = enemies[i];
+    broadphase.move_proxy(
+      p.get_proxy(), i, p.get_left_edge(), p.get_right_edge(), p.get_top_edge(), p.get_bottom_edge()
+    );
+  }
+
+  broadphase.update();
 }
 
 
@@ -188,46 +716,138 @@ void init(void)
 // callback
 void renderScene(void)
 {
+  auto render_start = std::chrono::steady_clock::now();
+
   // Erasing buffer
   glClear(GL_COLOR_BUFFER_BIT);
 
+  // Camera follows the player
+  double camera = previous_camera_offset + (camera_offset - previous_camera_offset) * render_alpha;
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+    glTranslated(camera, 0, 0);
+  glMatrixMode(GL_MODELVIEW);
+
   if(game_over){  // final message
     print_message(PRINT_BASE_X, PRINT_BASE_Y, game_over_message);
-    glutSwapBuffers(); 
-    return;
   }
-
-  if(win) {   // final message
+  else if(win) {   // final message
     print_message(PRINT_BASE_X, PRINT_BASE_Y, win_message);
+  }
+  else {
+    // Drawing elements
+    {
+      ScopedTimer timer(profiler, FrameSection::DrawArenaSection);
+      ring.draw();
+    }
+    {
+      ScopedTimer timer(profiler, FrameSection::DrawPlayersSection);
+      self.draw(render_alpha);
+      for(const Player &p: enemies){
+        p.draw(render_alpha);
+      }
+    }
+    {
+      ScopedTimer timer(profiler, FrameSection::DrawShotsSection);
+      const double *x = shots.get_xs(), *previous_x = shots.get_previous_xs();
+      const double *y = shots.get_ys(), *previous_y = shots.get_previous_ys();
+      for(size_t i = 0; i < shots.size(); i++) {
+        Shot::draw(
+          previous_x[i] + (x[i] - previous_x[i]) * render_alpha,
+          previous_y[i] + (y[i] - previous_y[i]) * render_alpha
+        );
+      }
+    }
+  }
+
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
+
+  if(show_profiler){
+    draw_profiler();
+  }
+
+  // Processing new frame
+  {
+    ScopedTimer timer(profiler, FrameSection::SwapSection);
     glutSwapBuffers(); 
-    return;
   }
 
-  // Drawing elements
-  ring.draw();
-  self.draw();
-  for(const Player &p: enemies){
-    p.draw();
+  // Closing the profiled frame (idle ticks and this render)
+  auto now = std::chrono::steady_clock::now();
+  if(trace.is_enabled()){
+    trace.record("render", "frame", render_start, now);
   }
-  for(Shot * shot: shots) {
-    shot->draw();
+  profiler.add(FrameSection::FrameTotal, std::chrono::duration<double, std::milli>(now - frame_end).count());
+  frame_end = now;
+  profiler.end_frame();
+  if(++profiler_frames % PROFILER_REFRESH == 0){
+    update_profiler_table();
   }
+}
 
-  // Processing new frame
-  glutSwapBuffers(); 
+
+//=============================================
+// Names the profiled sections: frame parts, then one per tick stage
+void setup_profiler(){
+  profiler.add_section("frame");
+  profiler.add_section("input");
+  profiler.add_section("previous state");
+  profiler.add_section("draw arena");
+  profiler.add_section("draw players");
+  profiler.add_section("draw shots");
+  profiler.add_section("swap");
+  for(size_t i = 0; i < tick_pipeline.get_stage_count(); i++){
+    profiler.add_section(tick_pipeline.get_stage_name(i));
+  }
+}
+
+
+//=============================================
+// Formats the min/avg/p99 table of the profiled sections
+// (refreshed every PROFILER_REFRESH frames so it stays readable)
+void update_profiler_table(){
+  char line[128];
+  profiler_table.resize(profiler.get_section_count() + 1);
+
+  snprintf(line, sizeof(line), "%-16s %6s %6s %6s  ms/%zu frames", "section", "min", "avg", "p99", profiler.get_frame_count());
+  profiler_table[0] = line;
+  for(size_t i = 0; i < profiler.get_section_count(); i++){
+    snprintf(line, sizeof(line), "%-16.16s %6.2f %6.2f %6.2f",
+      profiler.get_section_name(i).c_str(), profiler.get_min(i), profiler.get_mean(i), profiler.get_percentile(i, 99)
+    );
+    profiler_table[i + 1] = line;
+  }
+}
+
+
+//=============================================
+// Draws the profiler table over the game, in window coordinates
+void draw_profiler(){
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  gluOrtho2D(0, Width, 0, Height);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+
+  for(size_t i = 0; i < profiler_table.size(); i++){
+    print_message(PROFILER_MARGIN, Height - PROFILER_MARGIN - (i + 1) * PROFILER_LINE, profiler_table[i].data());
+  }
+
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
 }
 
 
 //========================================
 // callback
 void keyUp(unsigned char key, int x, int y){
-  key_status[key] = 0;
-  
-  // reseting legs to initial position when player stops
-  if(key == 'a' or key == 'd') {
-    self.reset_legs_position();
-  }
-
+  queue_input(InputEventType::KeyUp, key, x, y);
   glutPostRedisplay();
 }
 
@@ -245,35 +865,15 @@ void resetKeyStatus(){
 //============================================
 // callback
 void keyPress(unsigned char key, int x, int y){
-  switch (key)
-  {
-  case 'a':
-  case 'A':
-    key_status['a'] = 1;
-    break;
-
-  case 'd':
-  case 'D':
-    key_status['d'] = 1;
-    break;
-
-  case 'r':
-  case 'R':
-    if(game_over or win){
-      setup(svg);
-      game_over = false;
-      win = false;
-    }
-    break;
-
-  case 0x1b:  // ESC
+  if(key == 0x1b) {  // ESC
     exit(0);
-    break;
-
-  default:
-    break;
+  }
+  if(key == 'p' or key == 'P') {  // profiler table (not a game input)
+    show_profiler = !show_profiler;
+    return;
   }
 
+  queue_input(InputEventType::KeyDown, key, x, y);
   glutPostRedisplay();
 }
 
@@ -282,47 +882,154 @@ void keyPress(unsigned char key, int x, int y){
 // callback
 void idle(void){
   // Setting time between iter
-  double timeDifference = get_time_diff();
-
-  // Horizontal left motion===========
-  if(key_status['a']) {
-    // Checking arena limits
-    if(is_player_into_arena_horizontally(self, ring, HorizontalMoveDirection::Left)) {
-      // Checking collision against obstacles
-      if(!walking_collision(self, ring, enemies, HorizontalMoveDirection::Left, timeDifference)) {
-        // Walking
-        self.walk(timeDifference, HorizontalMoveDirection::Left);
-        if(!(win or game_over)){
-          set_camera(timeDifference, self.get_velocity(), HorizontalMoveDirection::Left);
-        }
-      }
+  double frameTime = get_time_diff();
+  if(frameTime > MAX_FRAME_TIME){
+    frameTime = MAX_FRAME_TIME;
+  }
+
+  // The world always advances in fixed steps, regardless of frame rate
+  sim_accumulator += frameTime;
+  while(sim_accumulator >= sim_step){
+    {
+      ScopedTimer timer(profiler, FrameSection::InputSection);
+      apply_input();
+    }
+    {
+      ScopedTimer timer(profiler, FrameSection::PreviousStateSection);
+      store_previous_state();
     }
+    update(sim_step);
+    for(size_t i = 0; i < tick_pipeline.get_stage_count(); i++){
+      profiler.add(FrameSection::TickSections + i, tick_pipeline.get_last_time(i));
+    }
+    sim_accumulator -= sim_step;
+    sim_tick++;
   }
 
-  // Horizontal right motion=========
-  if(key_status['d']) {
-    // Checking arena limits
-    if(is_player_into_arena_horizontally(self, ring, HorizontalMoveDirection::Right)) {
-      // Checking collision against obstacles
-      if(!walking_collision(self, ring, enemies,HorizontalMoveDirection::Right, timeDifference)) {
-        // Walking
-        self.walk(timeDifference, HorizontalMoveDirection::Right);
-        if(!(win or game_over)){
-          set_camera(timeDifference, self.get_velocity(), HorizontalMoveDirection::Right);
-        }
+  // Rendering between the last two steps
+  render_alpha = sim_accumulator / sim_step;
+  glutPostRedisplay();
+}
+
+
+//====================================================
+// Keeps the current state for render interpolation
+void store_previous_state(){
+  previous_camera_offset = camera_offset;
+  self.store_previous_state();
+  for(Player &enemy: enemies){
+    enemy.store_previous_state();
+  }
+  shots.store_previous_state();
+}
+
+
+//=============================================
+// Advances the game's world by timeDifference ms, running the tick stages
+// It must not call GLUT/GL (used by headless mode)
+void update(double timeDifference){
+  AllocStats allocated_before, allocated_after;
+  tick_time = timeDifference;
+  AllocTracker::get_total(allocated_before);
+
+  if(!trace.is_enabled()){
+    tick_pipeline.run(jobs);
+  } else {
+    trace.set_tick(sim_tick);
+    auto begin = std::chrono::steady_clock::now();
+    tick_pipeline.run(jobs);
+    trace.record("tick", "tick", begin, std::chrono::steady_clock::now());
+  }
+
+  AllocTracker::get_total(allocated_after);
+  count_tick_allocations(allocated_before, allocated_after);
+
+  // Outside the stages: exiting from a job system thread would join it with itself
+  check_level_stream();
+}
+
+
+//=============================================
+// Adds the heap activity of the tick that just ran (whole process:
+// every thread allocating during the tick, e.g. level streaming, counts)
+void count_tick_allocations(const AllocStats &before, const AllocStats &after){
+  uint64_t allocations = after.allocations - before.allocations;
+  tick_allocations.allocations += allocations;
+  tick_allocations.frees += after.frees - before.frees;
+  tick_allocations.bytes += after.bytes - before.bytes;
+  if(allocations == 0) return;
+
+  max_tick_allocations = std::max(max_tick_allocations, allocations);
+  allocating_ticks++;
+  last_allocating_tick = sim_tick;
+  if(no_alloc_after >= 0 and (long)sim_tick > no_alloc_after and first_late_tick < 0){
+    first_late_tick = sim_tick;
+  }
+}
+
+
+//=============================================
+// Declares the tick stages in game order, with the state each one reads and writes.
+// Stages touching disjoint state (e.g. self motion and shots motion) run concurrently
+void setup_pipeline(){
+  tick_pipeline.add_stage("level streaming",
+    SelfState | CameraState, ArenaState | EnemyState | BroadphaseState,
+    [] { stream_level(); });
+  tick_pipeline.add_stage("self motion",
+    InputState | ArenaState | EnemyState | GameState, SelfState | CameraState,
+    [] { move_self(tick_time); });
+  tick_pipeline.add_stage("shots motion",
+    0, ShotState,
+    [] { shots.integrate(tick_time); });
+  tick_pipeline.add_stage("broadphase",
+    SelfState | EnemyState | ShotState, BroadphaseState,
+    [] { find_candidates(); });
+  tick_pipeline.add_stage("shot hits",
+    ArenaState | SelfState | BroadphaseState, ShotState | EnemyState | BroadphaseState | GameState | CameraState,
+    [] { resolve_hits(); });
+  tick_pipeline.add_stage("enemies motion",
+    SelfState | ArenaState | BroadphaseState, EnemyState,
+    [] { move_enemies(tick_time); });
+  tick_pipeline.add_stage("enemy fire",
+    EnemyState, ShotState | BroadphaseState,
+    [] { fire_enemies(tick_time); });
+  tick_pipeline.add_stage("win check",
+    SelfState | ArenaState, GameState | CameraState,
+    [] { check_win(); });
+}
+
+
+//=============================================
+// Self player motion: walking, gravity and jump
+void move_self(double timeDifference){
+  // Enemies moved or died since the last tick
+  world.index_enemies();
+
+  // Horizontal motion (swept up to the first contact)==========
+  for(HorizontalMoveDirection direction: {HorizontalMoveDirection::Left, HorizontalMoveDirection::Right}) {
+    int key = (direction == HorizontalMoveDirection::Left) ? 'a' : 'd';
+    if(!key_status[key]) continue;
+
+    double displacement = timeDifference * self.get_velocity();
+    double toi = world.sweep(self, (direction == HorizontalMoveDirection::Left) ? -displacement : displacement, 0);
+    if(toi > 0) {
+      // Walking
+      self.walk(timeDifference * toi, direction);
+      if(!(win or game_over)){
+        set_camera(timeDifference * toi, self.get_velocity(), direction);
       }
     }
   }
 
 
+  // Free distances above and below the player within this step
+  double reach = self.get_vertical_reach(timeDifference, GRAVITY);
+  double room_up = world.sweep(self, 0, -reach) * reach;
+  double room_down = world.sweep(self, 0, reach) * reach;
+
   //Gravity physics=========================
   if(jump_state == JumpState::NotJumping) {
-    if(self.fall(
-        timeDifference, 
-        GRAVITY,
-        falling_collision(self, ring, enemies, timeDifference)  
-      )
-    ) {
+    if(self.fall(timeDifference, GRAVITY, room_down)) {
       fall_state = FallState::Falling;
     } else {
       fall_state = FallState::NotFalling;
@@ -333,145 +1040,253 @@ void idle(void){
   // Jump==============================
   if(jump_state == JumpState::Jumping){
     // If jump() returns 0, jump finished
-    if(!self.jump(
-        timeDifference, 
-        GRAVITY,
-        key_status[MOUSE_RIGHT],
-        jumping_collision(self, ring, enemies, timeDifference))
-      ) {
+    if(!self.jump(timeDifference, GRAVITY, key_status[MOUSE_RIGHT], room_up, room_down)) {
       jump_state = JumpState::NotJumping;
     }
   }
+}
 
 
-  // Treating shots=====================================
-  for (auto shot = shots.begin(); shot != shots.end();) {
-    bool is_shot_deleted = false;
+//=============================================
+// Broadphase pairs and narrow phase candidates of the shots
+void find_candidates(){
+  // Broadphase: enemies against self player
+  update_broadphase();
+  pairs.clear();
+  broadphase.find_pairs(pairs);
+
+  enemy_near_self.assign(enemies.size(), 0);
+  for(const ProxyPair &pair: pairs) {
+    int enemy_proxy = (broadphase.get_kind(pair.a) == ProxyKind::EnemyProxy) ? pair.a : pair.b;
+    enemy_near_self[broadphase.get_user(enemy_proxy)] = 1;
+  }
 
-    // Motion update
-    if(*shot) {
-        (*shot)->move(timeDifference); 
+  // Narrow phase candidates: players around the whole motion of each shot in the
+  // last step (sorted by shot, then enemy order; self player is enemies.size())
+  const double *x = shots.get_xs();
+  const double *y = shots.get_ys();
+  const double *previous_x = shots.get_previous_xs();
+  const double *previous_y = shots.get_previous_ys();
+  shot_candidates.clear();
+
+  for(size_t s = 0; s < shots.size(); s++) {
+    nearby_players.clear();
+    broadphase.query(
+      std::min(previous_x[s], x[s]), std::max(previous_x[s], x[s]),
+      std::min(previous_y[s], y[s]), std::max(previous_y[s], y[s]),
+      nearby_players
+    );
+
+    size_t first = shot_candidates.size();
+    for(int proxy: nearby_players) {
+      int other = (broadphase.get_kind(proxy) == ProxyKind::SelfProxy) ? enemies.size() : broadphase.get_user(proxy);
+      shot_candidates.push_back({ (int)s, other });
+    }
+    if(shot_candidates.size() - first > 1) {
+      std::sort(shot_candidates.begin() + first, shot_candidates.end(), [](const ProxyPair &p1, const ProxyPair &p2) {
+        return p1.b < p2.b;
+      });
     }
+  }
+}
 
-    // Getting position
-    double shot_x, shot_y;
-    (*shot)->get_pos(shot_x, shot_y);
-    
-    // Checking collision against enemies
-    for(auto enemy = enemies.begin(); enemy != enemies.end();) {  
-      if(
-        shot_x > (*enemy).get_left_edge() && 
-        shot_x < (*enemy).get_right_edge() &&
-        shot_y > (*enemy).get_top_edge() &&
-        shot_y < (*enemy).get_bottom_edge()  
-      ){
-        enemy = enemies.erase(enemy);
-        delete (*shot);
-        shot = shots.erase(shot);
-        is_shot_deleted = true;
-        break;
-      } 
-      else {
-        ++ enemy;
+
+//=============================================
+// Shots against players and obstacles, then removal of the hit ones
+void resolve_hits(){
+  // Hit tests along the motion of each shot in this step, so fast shots
+  // cannot tunnel through thin platforms or players (one batch, candidates
+  // first so test i is candidate i)
+  const double *shots_x = shots.get_xs();
+  const double *shots_y = shots.get_ys();
+  const double *shots_previous_x = shots.get_previous_xs();
+  const double *shots_previous_y = shots.get_previous_ys();
+
+  hit_tests.clear();
+  for(const ProxyPair &c: shot_candidates) {
+    const Player &target = (c.b < (int)enemies.size()) ? enemies[c.b] : self;
+    hit_tests.add(
+      shots_previous_x[c.a], shots_previous_y[c.a], shots_x[c.a], shots_y[c.a],
+      target.get_left_edge(), target.get_top_edge(), target.get_right_edge(), target.get_bottom_edge()
+    );
+  }
+
+  // Obstacles whose box the motion box of each shot touches (most shots fly in open space;
+  // the index only narrows obstacles down to cells, so boxes are compared too).
+  // Each thread keeps the touched obstacles of its shots for the serial pass below
+  for(std::vector<int> &touched: worker_obstacles) {
+    touched.clear();
+  }
+  shot_obstacles.resize(shots.size());
+  // (no captures: the job fits std::function without allocating)
+  jobs.parallel_for(shots.size(), SHOT_CHUNK, [](size_t begin, size_t end) {
+    const double *shots_x = shots.get_xs();
+    const double *shots_y = shots.get_ys();
+    const double *shots_previous_x = shots.get_previous_xs();
+    const double *shots_previous_y = shots.get_previous_ys();
+    unsigned thread = JobSystem::get_current_thread();
+    std::vector<int> &touched = worker_obstacles[thread];
+    for(size_t s = begin; s < end; s++) {
+      double min_x = std::min(shots_previous_x[s], shots_x[s]), max_x = std::max(shots_previous_x[s], shots_x[s]);
+      double min_y = std::min(shots_previous_y[s], shots_y[s]), max_y = std::max(shots_previous_y[s], shots_y[s]);
+
+      // Candidates appended, then filtered in place
+      size_t first = touched.size();
+      ring.query_obstacles(min_x, min_y, max_x, max_y, touched);
+      size_t kept = first;
+      for(size_t k = first; k < touched.size(); k++) {
+        if(geometry_tools::rect_overlaps_box(ring.get_obstacle(touched[k]), min_x, min_y, max_x, max_y)) {
+          touched[kept++] = touched[k];
+        }
       }
+      touched.resize(kept);
+      shot_obstacles[s] = { thread, first, kept - first };
+    }
+  });
+
+  // Then those shots against the obstacles they touch
+  obstacle_tests.resize(shots.size() + 1);
+  for(size_t s = 0; s < shots.size(); s++) {
+    obstacle_tests[s] = hit_tests.size();
+
+    const ShotObstacles &touched = shot_obstacles[s];
+    const int *obstacles = worker_obstacles[touched.thread].data() + touched.first;
+    for(size_t k = 0; k < touched.count; k++){
+      const svg_tools::Rect& r = ring.get_obstacle(obstacles[k]);
+      hit_tests.add(shots_previous_x[s], shots_previous_y[s], shots_x[s], shots_y[s], r.x, r.y, r.x + r.width, r.y + r.height);
     }
+  }
+  obstacle_tests[shots.size()] = hit_tests.size();
+  hit_tests.run();
 
-    // Prevent seg fault
-    if(is_shot_deleted) continue;
-    
-    // Collision against self player
-    if(
-      shot_x > self.get_left_edge() && 
-      shot_x < self.get_right_edge() &&
-      shot_y > self.get_top_edge() &&
-      shot_y < self.get_bottom_edge()  
-    ){
-      delete (*shot);
-      shot = shots.erase(shot);
-      is_shot_deleted = true;
-      game_over = true; //GAME OVER====================================GAME OVER
-      reset_camera((self.get_cx() - self.get_initial_cx()));
-      break;
-    } 
-
-    // Prevent seg fault
-    if(is_shot_deleted) continue;
-
-    // Checking collision against obstacles
-    for(const svg_tools::Rect& r: ring.get_obstacles()){
-      if(
-        shot_x > r.x && 
-        shot_x < (r.x + r.width) &&
-        shot_y > r.y &&
-        shot_y < (r.y + r.height)
-      ){
-        delete (*shot);
-        shot = shots.erase(shot);
-        is_shot_deleted = true;
-        break;
+
+  // Treating shots=====================================
+  enemy_dead.assign(enemies.size(), 0);
+  size_t candidate = 0;
+
+  for(size_t s = 0; s < shots.size(); s++) {
+    // Earliest obstacle along the motion
+    bool blocked = false;
+    double first_hit = 1;
+    for(size_t t = obstacle_tests[s]; t < obstacle_tests[s + 1]; t++){
+      if(hit_tests.is_hit(t) and hit_tests.get_time(t) <= first_hit){
+        first_hit = hit_tests.get_time(t);
+        blocked = true;
+      }
+    }
+
+    // Skipping candidates of previous shots
+    while(candidate < shot_candidates.size() and shot_candidates[candidate].a < (int)s) {
+      candidate++;
+    }
+
+    // Earliest enemy or self player reached. Players win ties against the obstacle,
+    // and enemies against the self player (candidate order)
+    int target = -1;
+    for(; candidate < shot_candidates.size() and shot_candidates[candidate].a == (int)s; candidate++) {
+      int other = shot_candidates[candidate].b;
+      if(other < (int)enemies.size() and enemy_dead[other]) continue;
+
+      double t = hit_tests.get_time(candidate);
+      if(hit_tests.is_hit(candidate) and (target < 0 ? t <= first_hit : t < first_hit)){
+        first_hit = hit_tests.get_time(candidate);
+        target = other;
       }
     }
 
-    // Prevent seg fault
-    if(is_shot_deleted) continue;
+    if(target >= 0){
+      shots.kill(s);
+
+      if(target < (int)enemies.size()) {
+        enemy_dead[target] = 1;
+      } else if(!game_over) {
+        game_over = true; //GAME OVER====================================GAME OVER
+        reset_camera((self.get_cx() - self.get_initial_cx()));
+      }
+    } else if(blocked) {
+      shots.kill(s);
+    }
 
     // Shot lifecycle
-    if (not (*shot)->is_valid()) {
-        delete (*shot);
-        shot = shots.erase(shot);
-    } 
-    else {
-     ++shot;
+    if (shots.is_expired(s)) {
+      shots.kill(s);
     }
   }
 
+  // Removing hit enemies and finished shots (keeping order)
+  size_t kept = 0;
+  for(size_t i = 0; i < enemies.size(); i++) {
+    if(enemy_dead[i]) {
+      broadphase.destroy_proxy(enemies[i].get_proxy());
+      continue;
+    }
+    enemy_near_self[kept] = enemy_near_self[i];
+    enemies[kept++] = enemies[i];
+  }
+  enemies.resize(kept);
+  enemy_near_self.resize(kept);
+  shots.compact();
+}
 
-  // Enemies motion==========
-  for(Player &enemy: enemies){
-
-    // enemies  always aim to self player
-    double self_distance_x = self.get_cx() - enemy.get_cx();
-    double self_distance_y = self.get_cy() - enemy.get_cy();
-    double rad = atan2(self_distance_y, abs(self_distance_x));
-    double deg = rad * 180.0/M_PI;
-    enemy.set_arm_angle(deg);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(0, 1);
+//=============================================
+// Enemies aim at self player and walk along their platforms
+void move_enemies(double timeDifference){
+  // Enemies motion (each enemy only reads self and the arena, so chunks run in parallel)==========
+  jobs.parallel_for(enemies.size(), ENEMY_CHUNK, [timeDifference](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++){
+      Player &enemy = enemies[i];
 
-    
-    int random_index = distrib(gen);
+      // enemies  always aim to self player
+      double self_distance_x = self.get_cx() - enemy.get_cx();
+      double self_distance_y = self.get_cy() - enemy.get_cy();
+      double rad = atan2(self_distance_y, abs(self_distance_x));
+      double deg = rad * 180.0/M_PI;
+      enemy.set_arm_angle(deg);
 
-    if(platform_end_detected(enemy, ring)){
-      enemy.revert_walk_direction();
-    }
+      if(world.platform_end_detected(enemy)){
+        enemy.revert_walk_direction();
+      }
     
-    HorizontalMoveDirection enemy_direcition = enemy.get_walk_direction();
+      HorizontalMoveDirection enemy_direcition = enemy.get_walk_direction();
     
-    if(!players_collision(self, enemy)) {
-      enemy.walk(timeDifference, enemy_direcition);
+      if(!(enemy_near_self[i] and CollisionWorld::players_collision(self, enemy))) {
+        enemy.walk(timeDifference, enemy_direcition);
+      }
     }
-  }
+  });
+}
 
 
-  // Choosing random enemy to shot
+//=============================================
+// A random enemy shoots every SHOT_INTERVAL
+void fire_enemies(double timeDifference){
+  // Choosing random enemy to shot: each one rolls on its own (tick, id) stream and the
+  // lowest roll fires, so the choice does not depend on the order of the enemies
   if(!enemies.empty() and shot_timer >= SHOT_INTERVAL){
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(0, enemies.size() - 1);
-    int random_index = distrib(gen);
-
-    auto enemy = enemies.begin(); // Inicializa o iterador
-    std::advance(enemy, random_index); 
-
-    if(enemy != enemies.end()){
-      shots.push_back((*enemy).shoot());
+    size_t shooter = 0;
+    uint64_t lowest = UINT64_MAX;
+    for(size_t i = 0; i < enemies.size(); i++) {
+      uint64_t roll = RngStream(rng, RngStreamId::EnemyFireStream, enemies[i].get_id(), sim_tick).next();
+      if(roll < lowest) {
+        lowest = roll;
+        shooter = i;
+      }
     }
 
+    add_shot(enemies[shooter].shoot());
+
     shot_timer = 0.0;
   }
 
+  // Updating timer
+  shot_timer += timeDifference;
+}
+
+
+//=============================================
+// Game ends if player reaches the end of the arena
+void check_win(){
   // game ends if player reaches the end of the arena
   if(self.get_right_edge() >= (ring.get_x() + ring.get_width())){
     win = true;  
@@ -481,156 +1296,336 @@ void idle(void){
       reset_camera((self.get_cx() - self.get_initial_cx()));
       camera_reset = 1;
     }
-  } 
+  }
+}
 
-  // Updating timer
-  shot_timer += timeDifference;
+
+//==============================================================
+// Runs the simulation without window for a fixed number of ticks
+void run_headless(long ticks, long bullet_hell)
+{
+  double dt = sim_step;
+  RngStream bullet_hell_rng(rng, RngStreamId::BulletHellStream);
+  auto start = std::chrono::steady_clock::now();
+
+  for(long tick = 0; tick < ticks; tick++){
+    spawn_bullet_hell(bullet_hell, bullet_hell_rng);
+    apply_input();
+    store_previous_state();
+    update(dt);
+    sim_tick++;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(end - start).count();
+
+  // Round trip of the final world through a snapshot
+  Snapshot snapshot;
+  save_world(snapshot);  // warms the buffer up
+  auto save_start = std::chrono::steady_clock::now();
+  save_world(snapshot);
+  auto save_end = std::chrono::steady_clock::now();
+  restore_world(snapshot);
+  auto restore_end = std::chrono::steady_clock::now();
+  double save_us = std::chrono::duration<double, std::micro>(save_end - save_start).count();
+  double restore_us = std::chrono::duration<double, std::micro>(restore_end - save_end).count();
+
+  const char *index_names[] = { "brute", "grid", "bvh" };
+
+  std::cout << "setup: " << setup_time << " ms" << std::endl;
+  std::cout << "ticks: " << ticks << " (dt " << dt << " ms)" << std::endl;
+  std::cout << "index: " << index_names[ring.get_index()] << std::endl;
+  std::cout << "threads: " << jobs.get_thread_count() << std::endl;
+  std::cout << "seed: " << rng.get_seed() << std::endl;
+  std::cout << "elapsed: " << elapsed << " s" << std::endl;
+  std::cout << "ticks/s: " << (elapsed > 0 ? ticks / elapsed : 0) << std::endl;
+  std::cout << "player: (" << self.get_cx() << ", " << self.get_cy() << ")" << std::endl;
+  std::cout << "enemies: " << enemies.size() << std::endl;
+  std::cout << "shots: " << shots.size() << " (peak " << shots.get_peak() << " of " << shots.get_capacity();
+  std::cout << ", dropped " << shots.get_dropped() << ", " << (shots.get_simd() ? "simd" : "scalar") << ")" << std::endl;
+  if(level_stream.is_enabled()){
+    std::cout << "level: " << level_stream.get_chunk_count() << " chunks, " << level_stream.get_resident_count() << " resident";
+    std::cout << " (" << level_stream.get_resident_obstacles() << " obstacles, peak " << level_stream.get_peak_obstacles() << ")";
+    std::cout << ", loads " << level_stream.get_loads() << ", decodes " << level_stream.get_decodes();
+    std::cout << ", stalls " << level_stream.get_stalls() << std::endl;
+  }
+  std::cout << "state: " << (game_over ? "game over" : (win ? "won" : "running")) << std::endl;
+  if(trace.is_enabled()){
+    std::cout << "trace: " << trace.size() << " events (" << trace.get_dropped() << " dropped) in " << trace_path << std::endl;
+  }
+  std::cout << "snapshot: " << snapshot.size() << " bytes (save " << save_us << " us, restore " << restore_us << " us)" << std::endl;
+
+  // Mean time of each tick stage
+  for(size_t i = 0; i < tick_pipeline.get_stage_count(); i++){
+    std::cout << "stage " << tick_pipeline.get_stage_name(i) << ": " << tick_pipeline.get_mean_time(i) << " ms" << std::endl;
+  }
+  if(counting){
+    print_counters();
+  }
+  if(AllocTracker::is_enabled()){
+    print_allocations();
+  }
+
+  // Steady state check (--assert-no-alloc)
+  if(first_late_tick >= 0){
+    std::cerr << "Allocation in a tick after tick " << no_alloc_after << " (first at tick " << first_late_tick << ")" << std::endl;
+    exit(1);
+  }
+}
+
+
+//===================================================================
+// Keeps target shots alive, fired from random points of the arena
+// in random directions (stress scenario for headless mode)
+void spawn_bullet_hell(long target, RngStream &rng)
+{
+  while((long)shots.size() < target){
+    double angle = rng.next_uniform(0, 2 * M_PI);
+    double x = rng.next_uniform(ring.get_x(), ring.get_x() + ring.get_width());
+    double y = rng.next_uniform(ring.get_y(), ring.get_y() + ring.get_height());
+    double point[2] = { x, y };
+    double direction[2] = { cos(angle), sin(angle) };
+    add_shot(Shot(point, direction));
+  }
+}
+
+
+//===================================================
+// callback
+void mouseClick(int button, int state, int x, int y) {
+  queue_input((state == GLUT_DOWN) ? InputEventType::MouseDown : InputEventType::MouseUp, button, x, y);
+}
+
+
+//============================
+// callback
+void mouseMotion(int x, int y)
+{
+  queue_input(InputEventType::MouseMove, 0, x, y);
   glutPostRedisplay();
 }
 
 
-//============================================
-// Checks collision against 2 players
-bool players_collision(Player p1, Player p2) {
-  if(
-    ((p1.get_right_edge() >= p2.get_left_edge() && p1.get_left_edge() <= p2.get_left_edge()) ||
-    (p1.get_left_edge() <= p2.get_right_edge() && p1.get_right_edge() >= p2.get_right_edge()))
-    &&
-    ((p1.get_bottom_edge() >= p2.get_top_edge() && p1.get_top_edge() <= p2.get_top_edge()) ||
-    (p1.get_top_edge() <= p2.get_bottom_edge() && p1.get_bottom_edge() >= p2.get_bottom_edge()))
-  ){
-    return true;
+//===================================================
+// Keeps an input from a callback until the next tick starts
+// (live input is ignored while replaying)
+void queue_input(InputEventType type, int code, int x, int y)
+{
+  if(replaying) return;
+  pending_input.push_back({ 0, (uint8_t)type, (uint8_t)code, (int16_t)x, (int16_t)y });
+}
+
+
+//===================================================
+// Applies the inputs due at the starting tick: the replayed ones,
+// or the queued ones (stamped with the tick and recorded)
+void apply_input()
+{
+  InputEvent event;
+
+  if(replaying) {
+    while(input_log.next_event(sim_tick, event)) {
+      apply_input_event(event);
+    }
+    return;
   }
-  return false;
+
+  for(InputEvent &e: pending_input) {
+    e.tick = sim_tick;
+    apply_input_event(e);
+    if(recording) input_log.add(e);
+  }
+  pending_input.clear();
 }
 
 
-//=====================================================
-// Detect platform limit under the player
-bool platform_end_detected(Player player, Arena arena){
+//===================================================
+// Game reaction to an input (no GL calls, also used by headless replays)
+void apply_input_event(const InputEvent &event)
+{
+  switch(event.type) {
+  case InputEventType::KeyDown:
+    switch (event.code)
+    {
+    case 'a':
+    case 'A':
+      key_status['a'] = 1;
+      break;
 
-  double floor_offset = 1;
+    case 'd':
+    case 'D':
+      key_status['d'] = 1;
+      break;
 
-  for(const svg_tools::Rect& r: arena.get_obstacles()) {
-    
-    // Check if player is over an obstacle
-    if(abs(player.get_bottom_edge() - r.y) <= floor_offset){
-      if(
-        (player.get_left_edge() <= r.x && player.get_right_edge() >= r.x) ||
-        (player.get_right_edge() >= (r.x + r.width) && player.get_left_edge() <= (r.x + r.width)) ||
-        (player.get_left_edge() <= arena.get_x()) ||
-        (player.get_right_edge() >= (arena.get_x() + arena.get_width()))
-      ){
-        return true;
+    case 'r':
+    case 'R':
+      if(game_over or win){
+        restore_world(initial_world);
       }
+      break;
+
+    default:
+      break;
     }
+    break;
 
-    // Treats players not over obstacles==========
-    else if(player.get_walk_direction() == HorizontalMoveDirection::Left) {
-      //arena collision
-      if(player.get_left_edge() <= arena.get_x()) return true;
-      // obstacles collision
-      if( 
-      (player.get_left_edge() <= (r.x + r.width)) &&  
-      (player.get_left_edge() >= (r.x)) &&
-      (
-        (((r.y + r.height) >= player.get_top_edge()) && 
-         ((r.y) <= player.get_top_edge())
-        ) ||
-        
-        ( ((r.y) <= player.get_bottom_edge()) &&
-          ((r.y + r.height) >= player.get_bottom_edge())
-        ) ||
-        (((r.y) >= player.get_top_edge()) &&
-         (r.y + r.height) <= player.get_bottom_edge()
-        )
-      )
-      ){
-        return true;
-      }
+  case InputEventType::KeyUp:
+    key_status[event.code] = 0;
+
+    // reseting legs to initial position when player stops
+    if(event.code == 'a' or event.code == 'd') {
+      self.reset_legs_position();
     }
+    break;
 
-    // Rightward motion====
-    else {
-      //arena collision
-      if(player.get_right_edge() >= (arena.get_x() + arena.get_width())) return true;
-
-      // obstacles collision
-      if(
-        // by width 
-        (player.get_right_edge() >= (r.x)) &&  
-        (player.get_right_edge() <= (r.x + r.width)) &&
-        // by height
-        ( 
-          (((r.y + r.height) >= player.get_top_edge()) && 
-           ((r.y) <= player.get_top_edge())
-          ) || 
-
-          ( ((r.y) <= player.get_bottom_edge()) &&
-            ((r.y + r.height) >= player.get_bottom_edge())
-          ) ||
-  
-          (((r.y) >= player.get_top_edge()) && 
-           (r.y + r.height) <= player.get_bottom_edge()
-          )
-        )
-      ){
-        return true;
+  case InputEventType::MouseDown:
+    if(event.code == GLUT_RIGHT_BUTTON) {
+      // The jump key can be activated only when the player is not jumping
+      if(jump_state == JumpState::NotJumping and fall_state == FallState::NotFalling){
+        jump_state = JumpState::Jumping;
+        key_status[MOUSE_RIGHT] = 1;
       }
     }
+    else if(event.code == GLUT_LEFT_BUTTON) {
+      add_shot(self.shoot());
+    }
+    break;
+
+  case InputEventType::MouseUp:
+    if(event.code == GLUT_RIGHT_BUTTON) {
+      key_status[MOUSE_RIGHT] = 0;  // it's necessary to compute when mouse button is pressed to keep the jump up
+    }
+    break;
+
+  case InputEventType::MouseMove: {
+    // Mapping mouse position into virtual world
+    // Getting displacement proportion within window and
+    // transposing this proportion to virtual world
+    double mapped_mouse_pos_y = (-ring.get_height() * ((double)event.y/(double)Height)) - ring.get_y(); 
+    double mapped_mouse_pos_x = (ring.get_height() * ((double)event.x/(double)Width)) + ring.get_x();
+    
+    double mapped_mouse_displacement_y = mapped_mouse_pos_y - (-self.get_cy());
+    double mapped_mouse_displacement_x = 
+      mapped_mouse_pos_x - 
+      self.get_cx() + 
+      (self.get_cx() - self.get_initial_cx()); // offset because arena is too large
+
+    // Calculating arms angle based on mouse angle with player                                                                          
+    double rad = atan2(mapped_mouse_displacement_y, abs(mapped_mouse_displacement_x)); // abs(x) for 1 and 4 quadrants
+    double deg = rad * 180.0/M_PI;
+
+    self.set_arm_angle(-deg);
+    break;
+  }
+
+  default:
+    break;
   }
-  return false;
 }
 
 
 //===================================================
-// callback
-void mouseClick(int button, int state, int x, int y) {
-  if(button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN) {
+// Reads a finite number greater than 0 (the whole text must be a number)
+bool parse_positive(const char *text, double &value)
+{
+  char *end = nullptr;
+  value = strtod(text, &end);
+  return end != text and *end == '\0' and std::isfinite(value) and value > 0;
+}
 
-    // The jump key can be activated only when the player is not jumping
-    if(jump_state == JumpState::NotJumping and fall_state == FallState::NotFalling){
-      jump_state = JumpState::Jumping;
-      key_status[MOUSE_RIGHT] = 1;
-    }
-    return;
+
+//===================================================
+// Writes the recorded inputs (at exit, also when leaving with ESC)
+void save_recording()
+{
+  if(!recording) return;
+  if(!input_log.save(record_path)) {
+    std::cerr << "Could not write " << record_path << std::endl;
   }
+}
 
-  if(button == GLUT_RIGHT_BUTTON && state == GLUT_UP) {
-    key_status[MOUSE_RIGHT] = 0;  // it's necessary to compute when mouse button is pressed to keep the jump up
+
+//===================================================
+// Checks which hardware counters this machine gives and turns
+// the stage counting on if any (it runs without them otherwise)
+void setup_counters()
+{
+  PerfCounters probe;
+  if(!probe.open()){
+    counter_error = probe.get_error();
+    std::cerr << "Hardware counters unavailable (" << strerror(counter_error) << "), stages are not counted" << std::endl;
     return;
   }
 
-  if(button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
-    shots.push_back(self.shoot());
+  for(int c = 0; c < PerfCounterCount; c++){
+    counter_available[c] = probe.has((PerfCounterId)c);
+  }
+  tick_pipeline.set_counting(true);
+}
+
+
+//===================================================
+// Per stage: cycles per run, instructions per cycle and misses
+// per thousand instructions (n/a for counters this machine lacks)
+void print_counters()
+{
+  if(counter_error != 0){
+    std::cout << "counters: unavailable (" << strerror(counter_error) << ")" << std::endl;
     return;
   }
+
+  for(size_t i = 0; i < tick_pipeline.get_stage_count(); i++){
+    const uint64_t *v = tick_pipeline.get_counters(i).values;
+    long runs = std::max(tick_pipeline.get_runs(i), 1L);
+    double instructions = std::max<double>(v[InstructionsCounter], 1);
+
+    std::cout << "counters " << tick_pipeline.get_stage_name(i) << ": ";
+    if(counter_available[CyclesCounter]) std::cout << (double)v[CyclesCounter] / runs << " cycles/run";
+    else std::cout << "n/a cycles/run";
+
+    std::cout << ", IPC ";
+    if(counter_available[CyclesCounter] and counter_available[InstructionsCounter] and v[CyclesCounter] > 0){
+      std::cout << (double)v[InstructionsCounter] / v[CyclesCounter];
+    } else std::cout << "n/a";
+
+    std::cout << ", cache MPKI ";
+    if(counter_available[CacheMissesCounter] and counter_available[InstructionsCounter]){
+      std::cout << v[CacheMissesCounter] * 1000.0 / instructions;
+    } else std::cout << "n/a";
+
+    std::cout << ", branch MPKI ";
+    if(counter_available[BranchMissesCounter] and counter_available[InstructionsCounter]){
+      std::cout << v[BranchMissesCounter] * 1000.0 / instructions;
+    } else std::cout << "n/a";
+    std::cout << std::endl;
+  }
 }
 
 
-//============================
-// callback
-void mouseMotion(int x, int y)
+//===================================================
+// Heap activity of the ticks and of each stage's own thread
+void print_allocations()
 {
-  // Mapping mouse position into virtual world
-  // Getting displacement proportion within window and
-  // transposing this proportion to virtual world
-  double mapped_mouse_pos_y = (-ring.get_height() * ((double)y/(double)Height)) - ring.get_y(); 
-  double mapped_mouse_pos_x = (ring.get_height() * ((double)x/(double)Width)) + ring.get_x();
-  
-  double mapped_mouse_displacement_y = mapped_mouse_pos_y - (-self.get_cy());
-  double mapped_mouse_displacement_x = 
-    mapped_mouse_pos_x - 
-    self.get_cx() + 
-    (self.get_cx() - self.get_initial_cx()); // offset because arena is too large
+  std::cout << "allocations: " << tick_allocations.allocations << " in ticks (" << tick_allocations.bytes << " bytes, ";
+  std::cout << tick_allocations.frees << " frees), max " << max_tick_allocations << " per tick, ";
+  std::cout << allocating_ticks << " ticks allocating, last at tick " << last_allocating_tick << std::endl;
+
+  for(size_t i = 0; i < tick_pipeline.get_stage_count(); i++){
+    const AllocStats &a = tick_pipeline.get_allocations(i);
+    std::cout << "allocations " << tick_pipeline.get_stage_name(i) << ": " << a.allocations;
+    std::cout << " (" << a.bytes << " bytes, " << a.frees << " frees)" << std::endl;
+  }
+}
 
-  // Calculating arms angle based on mouse angle with player                                                                          
-  double rad = atan2(mapped_mouse_displacement_y, abs(mapped_mouse_displacement_x)); // abs(x) for 1 and 4 quadrants
-  double deg = rad * 180.0/M_PI;
 
-  self.set_arm_angle(-deg);
-  
-  glutPostRedisplay();
+//===================================================
+// Writes the kept trace events (at exit, also when leaving with ESC)
+void save_trace()
+{
+  if(!trace.is_enabled()) return;
+  if(!trace.save(trace_path, jobs.get_thread_count())) {
+    std::cerr << "Could not write " << trace_path << std::endl;
+  }
 }
 
 
@@ -644,18 +1639,15 @@ void set_camera(double time, double velocity, HorizontalMoveDirection direction)
     displacement *= -1;
   }
 
-  glMatrixMode(GL_PROJECTION);             
-    glTranslated(displacement, 0, 0);
-  glMatrixMode(GL_MODELVIEW);
+  camera_offset += displacement;
 }
 
 
 //====================================
 // set camera position absolutely
 void reset_camera(double displacement) {
-  glMatrixMode(GL_PROJECTION);             
-    glTranslated(displacement, 0, 0);
-  glMatrixMode(GL_MODELVIEW);
+  camera_offset += displacement;
+  previous_camera_offset = camera_offset;  // no interpolation across a reset
 }
 
 
@@ -672,286 +1664,6 @@ double get_time_diff()
 }
 
 
-//==================================================================================================
-// Checks if player is into arena
-bool is_player_into_arena_horizontally(Player player, Arena arena, HorizontalMoveDirection direction)
-{
-  if(direction == HorizontalMoveDirection::Left) {
-    return (player.get_left_edge() >= arena.get_x()); 
-  }
-  // Right
-  return (player.get_right_edge() <= (arena.get_x() + arena.get_width()));
-}
-
-
-//===============================================================================================================================
-// Checks horizontal collision
-bool walking_collision(Player &player, Arena arena, std::list<Player> enemies, HorizontalMoveDirection direction, double timeDiff) {
-  
-  double vertical_offset = timeDiff * player.get_velocity() + 0.1;
-  
-  // Right motion==================================
-  if(direction == HorizontalMoveDirection::Right) {
-    // Obstacles collision================================
-    for(const svg_tools::Rect& r: arena.get_obstacles()) {
-      if(
-        // by width 
-        (player.get_right_edge() >= (r.x)) &&  
-        (player.get_right_edge() <= (r.x + r.width)) &&
-        // by height
-        ( 
-          (((r.y + r.height - vertical_offset) >= player.get_top_edge()) && 
-           ((r.y) <= player.get_top_edge())
-          ) || 
-
-          ( ((r.y + vertical_offset) <= player.get_bottom_edge()) &&
-            ((r.y + r.height) >= player.get_bottom_edge())
-          ) ||
-  
-          (((r.y) >= player.get_top_edge()) && 
-           (r.y + r.height) <= player.get_bottom_edge()
-          )
-        )
-      ){
-        // Not necessary
-        // double new_cx = player.get_cx() - (player.get_right_edge() - r.x);
-        // player.set_cx(new_cx);
-        return true;
-      }
-    }
-
-    // Enemy collision====================
-    for(const Player &enemy: enemies) {
-      if(
-        // by width 
-        (player.get_right_edge() >= enemy.get_left_edge()) &&  
-        (player.get_right_edge() <= enemy.get_right_edge()) &&
-        // by height
-        ( 
-          (((enemy.get_bottom_edge() - vertical_offset) >= player.get_top_edge()) && 
-           (enemy.get_top_edge() <= player.get_top_edge())
-          ) || 
-
-          ( ((enemy.get_top_edge() + vertical_offset) <= player.get_bottom_edge()) &&
-            (enemy.get_bottom_edge() >= player.get_bottom_edge())
-          ) ||
-
-          ((enemy.get_top_edge() >= player.get_top_edge()) && 
-           enemy.get_bottom_edge() <= player.get_bottom_edge()
-          )
-        )
-      ){
-
-        double new_cx = player.get_cx() - (player.get_right_edge() - enemy.get_left_edge());
-        player.set_cx(new_cx);
-
-        return true;
-      }
-    }
-
-    return false;
-  }
-
-  // Left motion=========================================
-  for(const svg_tools::Rect& r: arena.get_obstacles()) {
-    // obstacles collision
-    if( 
-      (player.get_left_edge() <= (r.x + r.width)) &&  
-      (player.get_left_edge() >= (r.x)) &&
-      (
-        (((r.y + r.height - vertical_offset) >= player.get_top_edge()) && 
-         ((r.y) <= player.get_top_edge())
-        ) ||
-        
-        ( ((r.y + vertical_offset) <= player.get_bottom_edge()) &&
-          ((r.y + r.height) >= player.get_bottom_edge())
-        ) ||
-        (((r.y) >= player.get_top_edge()) &&
-         (r.y + r.height) <= player.get_bottom_edge()
-        )
-      )
-    ){
-      // Not necessary
-      // double new_cx = player.get_cx() + ((r.x + r.width) - player.get_left_edge());
-      // player.set_cx(new_cx);
-      return true;
-    }
-  }
-  // enemies collision
-  for(const Player &enemy: enemies) {
-    if( 
-      (player.get_left_edge() <= enemy.get_right_edge()) &&  
-      (player.get_left_edge() >= enemy.get_left_edge()) &&
-      (
-        (((enemy.get_bottom_edge() - vertical_offset) >= player.get_top_edge()) && 
-         (enemy.get_top_edge() <= player.get_top_edge())
-        ) ||
-        
-        ( ((enemy.get_top_edge() + vertical_offset) <= player.get_bottom_edge()) &&
-          (enemy.get_bottom_edge() >= player.get_bottom_edge())
-        ) ||
-        ((enemy.get_top_edge() >= player.get_top_edge()) &&
-         enemy.get_bottom_edge() <= player.get_bottom_edge()
-        )
-      )
-    ){
-
-      // correction for low processing pcs
-      double new_cx = player.get_cx() + (enemy.get_right_edge() - player.get_left_edge());
-      player.set_cx(new_cx);
-
-      return true;
-    }
-  }
-
-  return false;
-}
-
-
-//=============================================================================================
-// Checks collision when player is jumping
-bool jumping_collision(Player &player, Arena arena, std::list<Player> enemies, double timeDiff)
-{ 
-  // This factor avoid player halting horizontally against the obstacles when it's jumping.
-  //
-  // This is a hitbox adjustment.
-  //
-  // The horizontal motion is controlled by another function and the player stops when
-  // it's against the obstacle limit. The "horizontal_offset" does a little adjustment in this limit 
-  // for the vertical motion function, once the vertical motion function also leads
-  // with horizontal limits and stops the jump based on horizontal limits too.
-  //
-  // Without this adjustment, the player stucks in the wall when it's jumping
-
-  // TODO - this offset is not working because the displacement grows with time
-  double horizontal_offset = timeDiff * player.get_velocity() + 0.1;
-
-  if(player.get_jump_phase() == JumpPhase::Up) {
-    // Obstacles collision==============================
-    for(const svg_tools::Rect& r: arena.get_obstacles()) {
-      if(
-        (((player.get_top_edge() <= (r.y + r.height)) && (player.get_top_edge() >= r.y))  && 
-        (
-          ((player.get_right_edge() >= r.x + horizontal_offset) && (player.get_left_edge() <= r.x)) ||
-          ((player.get_left_edge() <= (r.x + r.width - horizontal_offset)) && (player.get_right_edge() >= (r.x + r.width))) ||
-          ((player.get_left_edge() >= r.x) && (player.get_right_edge() <= (r.x + r.width)))
-        )) ||
-        (player.get_top_edge() <= arena.get_y())
-      ){
-        return true;
-      } 
-    }
-    // Enemy coliision===============
-    for(const Player &enemy: enemies) {
-      if(
-        (((player.get_top_edge() <= enemy.get_bottom_edge()) && (player.get_top_edge() >= enemy.get_top_edge()))  && 
-        (
-          ((player.get_right_edge() >= enemy.get_left_edge() + horizontal_offset) && (player.get_left_edge() <= enemy.get_left_edge())) ||
-          ((player.get_left_edge() <= (enemy.get_right_edge() - horizontal_offset)) && (player.get_right_edge() >= enemy.get_right_edge())) ||
-          ((player.get_left_edge() >= enemy.get_left_edge()) && (player.get_right_edge() <= enemy.get_right_edge()))
-        ))
-      ){
-        return true;
-      } 
-    }
-    return false;
-  }
-
-  //Down================================
-  // low processing pcs correction
-  if(player.get_bottom_edge() >= (arena.get_y() + arena.get_height())){        
-    double new_cy = player.get_cy() - (player.get_bottom_edge() - (arena.get_y() + arena.get_height()));
-    player.set_cy(new_cy);
-  }
-
-  for(const svg_tools::Rect& r: arena.get_obstacles()) {
-    if(
-      ((player.get_bottom_edge() >= (r.y)) && (player.get_bottom_edge() <= (r.y + r.height))) && 
-      (
-        ((player.get_right_edge() >= r.x + horizontal_offset) && (player.get_left_edge() <= r.x)) ||
-        ((player.get_left_edge() <= (r.x + r.width - horizontal_offset)) && (player.get_right_edge() >= (r.x + r.width))) ||
-        ((player.get_left_edge() >= r.x) && (player.get_right_edge() <= (r.x + r.width)))
-      )
-    ){      
-      // Respecting hitboxes
-      double new_cy = player.get_cy() - (player.get_bottom_edge() - r.y);
-      player.set_cy(new_cy);
-
-      return true;
-    } 
-  }
-
-   for(const Player &enemy: enemies) {
-    if(
-      ((player.get_bottom_edge() >= enemy.get_top_edge()) && (player.get_bottom_edge() <= enemy.get_bottom_edge())) && 
-      (
-        ((player.get_right_edge() >= enemy.get_left_edge() + horizontal_offset) && (player.get_left_edge() <= enemy.get_left_edge())) ||
-        ((player.get_left_edge() <= (enemy.get_right_edge() - horizontal_offset)) && (player.get_right_edge() >= enemy.get_right_edge())) ||
-        ((player.get_left_edge() >= enemy.get_left_edge()) && (player.get_right_edge() <= enemy.get_right_edge()))
-      )
-    ){
-      
-      // correction for low processing pcs
-      double new_cy = player.get_cy() - (player.get_bottom_edge() - enemy.get_top_edge());
-      player.set_cy(new_cy);
-
-      return true;
-    } 
-   }
-  return false;
-}
-
-
-//============================================================================================
-// Checks collision when player is falling
-bool falling_collision(Player &player, Arena arena, std::list<Player> enemies, double timeDiff)
-{
-  double horizontal_offset = timeDiff * player.get_velocity() + 0.1;
-
-  // low processing pcs correction
-  if(player.get_bottom_edge() >= (arena.get_y() + arena.get_height())){        
-    double new_cy = player.get_cy() - (player.get_bottom_edge() - (arena.get_y() + arena.get_height()));
-    player.set_cy(new_cy);
-  }
-
-  // obstacles collision
-  for(const svg_tools::Rect& r: arena.get_obstacles()) {
-    if(
-      ((player.get_bottom_edge() >= (r.y)) && (player.get_bottom_edge() <= (r.y + r.height))) && 
-      (
-        ((player.get_right_edge() >= r.x + horizontal_offset) && (player.get_left_edge() <= r.x)) ||
-        ((player.get_left_edge() <= (r.x + r.width - horizontal_offset)) && (player.get_right_edge() >= (r.x + r.width))) ||
-        ((player.get_left_edge() >= r.x) && (player.get_right_edge() <= (r.x + r.width)))
-      )
-    ){
-      // Respecting hitboxes
-      double new_cy = player.get_cy() - (player.get_bottom_edge() - r.y);
-      player.set_cy(new_cy);
-      
-      return true;
-    } 
-  }
-  // Enemy collision
-  for(const Player &enemy: enemies) {
-    if(
-    ((player.get_bottom_edge() >= enemy.get_top_edge()) && (player.get_bottom_edge() <= enemy.get_bottom_edge())) && 
-    (
-      ((player.get_right_edge() >= enemy.get_left_edge() + horizontal_offset) && (player.get_left_edge() <= enemy.get_left_edge())) ||
-      ((player.get_left_edge() <= (enemy.get_right_edge() - horizontal_offset)) && (player.get_right_edge() >= enemy.get_right_edge())) ||
-      ((player.get_left_edge() >= enemy.get_left_edge()) && (player.get_right_edge() <= enemy.get_right_edge()))
-    )
-    ){
-      // correction for low processing pcs
-      double new_cy = player.get_cy() - (player.get_bottom_edge() - enemy.get_top_edge());
-      player.set_cy(new_cy);
-      
-      return true;
-    } 
-  }  
-  return false;
-}
-
-
 //===================================================
 // Prints messages in the screen
 void print_message(double x, double y, char * message)
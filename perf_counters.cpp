@@ -0,0 +1,122 @@
+#include "perf_counters.h"
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+// Hardware event of each counter
+static const uint64_t counter_events[PerfCounterCount] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES,
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static const char *counter_names[PerfCounterCount] = {
+  "cycles",
+  "instructions",
+  "cache-misses",
+  "branch-misses"
+};
+
+
+/// @brief Opens the counters of the calling thread and starts them
+/// @return false if no counter is available (see get_error())
+bool PerfCounters::open()
+{
+  PerfCounters::close();
+
+  for(int c = 0; c < PerfCounterCount; c++) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = counter_events[c];
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = (PerfCounters::leader < 0);  // the group starts once complete
+
+    // Calling thread, any cpu; the first counter opened leads the group
+    int fd = syscall(SYS_perf_event_open, &attr, 0, -1, PerfCounters::leader, 0);
+    if(fd < 0) {
+      if(PerfCounters::error == 0) PerfCounters::error = errno;
+      continue;
+    }
+
+    if(PerfCounters::leader < 0) PerfCounters::leader = fd;
+    PerfCounters::fds[c] = fd;
+    PerfCounters::slots[c] = PerfCounters::opened++;
+  }
+
+  if(PerfCounters::leader < 0) return false;
+
+  ioctl(PerfCounters::leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(PerfCounters::leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+
+/// @brief Stops and releases the counters
+void PerfCounters::close()
+{
+  for(int c = 0; c < PerfCounterCount; c++) {
+    if(PerfCounters::fds[c] >= 0) ::close(PerfCounters::fds[c]);
+    PerfCounters::fds[c] = -1;
+    PerfCounters::slots[c] = -1;
+  }
+  PerfCounters::leader = -1;
+  PerfCounters::opened = 0;
+  PerfCounters::error = 0;
+}
+
+
+PerfCounters::~PerfCounters()
+{
+  PerfCounters::close();
+}
+
+
+/// @brief Current values since open(), scaled up when the kernel multiplexed the group
+/// @param sample
+void PerfCounters::read(PerfSample &sample) const
+{
+  memset(&sample, 0, sizeof(sample));
+  if(PerfCounters::leader < 0) return;
+
+  // nr, time enabled, time running, then one value per counter of the group
+  uint64_t data[3 + PerfCounterCount];
+  ssize_t bytes = ::read(PerfCounters::leader, data, sizeof(data));
+  if(bytes < (ssize_t)((3 + PerfCounters::opened) * sizeof(uint64_t))) return;
+
+  double scale = (data[2] > 0 && data[2] < data[1]) ? (double)data[1] / data[2] : 1;
+  for(int c = 0; c < PerfCounterCount; c++) {
+    if(PerfCounters::slots[c] >= 0) {
+      sample.values[c] = data[3 + PerfCounters::slots[c]] * scale;
+    }
+  }
+}
+
+
+// Getters===========
+bool PerfCounters::is_open() const
+{
+  return PerfCounters::leader >= 0;
+}
+
+bool PerfCounters::has(PerfCounterId counter) const
+{
+  return PerfCounters::slots[counter] >= 0;
+}
+
+int PerfCounters::get_error() const
+{
+  return PerfCounters::error;
+}
+
+const char *PerfCounters::get_name(PerfCounterId counter)
+{
+  return counter_names[counter];
+}
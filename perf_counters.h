@@ -0,0 +1,49 @@
+#ifndef perf_counters_h
+#define perf_counters_h
+
+#include <cstdint>
+#include <cstddef>
+
+enum PerfCounterId {
+  CyclesCounter,
+  InstructionsCounter,
+  CacheMissesCounter,
+  BranchMissesCounter,
+  PerfCounterCount
+};
+
+/// @brief Values of the hardware counters (0 for the missing ones)
+struct PerfSample {
+  uint64_t values[PerfCounterCount];
+};
+
+/// @brief Hardware counters of the calling thread (perf_event_open, user space only),
+/// read together as one group. Counters the machine or the kernel does not provide
+/// (containers, VMs, perf_event_paranoid) are left out; when none can be opened
+/// every read gives zeros, so callers never have to special-case them
+class PerfCounters {
+
+  // Private by default
+  int fds[PerfCounterCount] = { -1, -1, -1, -1 };
+  int slots[PerfCounterCount] = { -1, -1, -1, -1 };  // position in the group read
+  int leader = -1;
+  size_t opened = 0;
+  int error = 0;  // errno of the first counter that failed
+
+  public:
+    PerfCounters(){}
+    ~PerfCounters();
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+    bool open();
+    void close();
+    void read(PerfSample &sample) const;
+
+    // getters
+    bool is_open() const;
+    bool has(PerfCounterId counter) const;
+    int get_error() const;
+    static const char *get_name(PerfCounterId counter);
+};
+
+#endif
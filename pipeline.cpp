@@ -0,0 +1,213 @@
+#include "pipeline.h"
+#include <chrono>
+
+
+//================================================
+// Hardware counters of the calling thread (opened on its first use)
+static const PerfCounters &thread_counters()
+{
+  static thread_local PerfCounters counters;
+  static thread_local bool opened = false;
+  if(!opened) {
+    counters.open();
+    opened = true;
+  }
+  return counters;
+}
+
+
+// Time (ms), hardware counters and heap activity of a stage run
+struct StageCost {
+  double time;
+  PerfSample counters;
+  AllocStats allocations;
+};
+
+// Inclusive cost of the stages this thread ran while waiting inside the stage it is measuring.
+// It is taken off that stage, so every stage is charged only for its own work
+static thread_local StageCost nested_cost = {};
+static thread_local int stage_depth = 0;  // stages being measured on this thread
+
+
+//================================================
+// Adds (sign 1) or takes off (sign -1) a cost
+static void add_cost(StageCost &total, const StageCost &cost, int sign)
+{
+  total.time += sign * cost.time;
+  for(int c = 0; c < PerfCounterCount; c++) {
+    total.counters.values[c] += sign * cost.counters.values[c];
+  }
+  total.allocations.allocations += sign * cost.allocations.allocations;
+  total.allocations.frees += sign * cost.allocations.frees;
+  total.allocations.bytes += sign * cost.allocations.bytes;
+}
+
+
+/// @brief Appends a stage after the current ones
+/// @param name shown with the timings
+/// @param reads state read by the stage
+/// @param writes state written by the stage
+/// @param run
+void Pipeline::add_stage(const std::string &name, uint32_t reads, uint32_t writes, std::function<void()> run)
+{
+  Stage stage = { name, reads, writes, std::move(run) };
+  size_t index = Pipeline::stages.size();
+
+  // Waiting for every earlier stage touching the same state (one of both writing)
+  for(size_t i = 0; i < index; i++) {
+    Stage &earlier = Pipeline::stages[i];
+    if((earlier.writes & (reads | writes)) || (earlier.reads & writes)) {
+      earlier.dependents.push_back(index);
+      stage.dependencies++;
+    }
+  }
+
+  Pipeline::stages.push_back(std::move(stage));
+  Pipeline::remaining.reset(new std::atomic<size_t>[Pipeline::stages.size()]);
+}
+
+
+//================================================
+// Runs a stage as a task, then starts the dependents it was the last to wait for
+void Pipeline::start(size_t index)
+{
+  // Small enough to be stored in the task itself (no allocation per stage)
+  Pipeline::jobs->run([this, index] {
+    Stage &stage = Pipeline::stages[index];
+    PerfSample before = {}, after = {};
+    AllocStats allocated_before, allocated_after;
+
+    // Stages run by this thread while this one waits are counted apart
+    StageCost outer = nested_cost;
+    nested_cost = {};
+    stage_depth++;
+
+    // Only work done on this thread is counted (not the tasks the stage hands to others)
+    AllocTracker::get_thread(allocated_before);
+    if(Pipeline::counting) thread_counters().read(before);
+    auto begin = std::chrono::steady_clock::now();
+    stage.run();
+    auto end = std::chrono::steady_clock::now();
+    if(Pipeline::counting) thread_counters().read(after);
+    AllocTracker::get_thread(allocated_after);
+    stage_depth--;
+
+    StageCost inclusive = {};
+    inclusive.time = std::chrono::duration<double, std::milli>(end - begin).count();
+    for(int c = 0; c < PerfCounterCount; c++) {
+      inclusive.counters.values[c] = after.values[c] - before.values[c];
+    }
+    inclusive.allocations.allocations = allocated_after.allocations - allocated_before.allocations;
+    inclusive.allocations.frees = allocated_after.frees - allocated_before.frees;
+    inclusive.allocations.bytes = allocated_after.bytes - allocated_before.bytes;
+
+    // Own cost: without the nested stages (already charged to themselves)
+    StageCost own = inclusive;
+    add_cost(own, nested_cost, -1);
+    nested_cost = outer;
+    if(stage_depth > 0) add_cost(nested_cost, inclusive, 1);
+
+    for(int c = 0; c < PerfCounterCount; c++) {
+      stage.counters.values[c] += own.counters.values[c];
+    }
+    stage.allocations.allocations += own.allocations.allocations;
+    stage.allocations.frees += own.allocations.frees;
+    stage.allocations.bytes += own.allocations.bytes;
+    stage.last_time = own.time;
+    if(Pipeline::trace != nullptr) {
+      Pipeline::trace->record(stage.name.c_str(), "stage", begin, end);
+    }
+    stage.total_time += stage.last_time;
+    stage.runs++;
+
+    for(size_t dependent: stage.dependents) {
+      if(Pipeline::remaining[dependent].fetch_sub(1) == 1) {
+        Pipeline::start(dependent);
+      }
+    }
+  }, Pipeline::pending);
+}
+
+
+/// @brief Runs every stage once and returns when all are done
+/// @param jobs
+void Pipeline::run(JobSystem &jobs)
+{
+  Pipeline::jobs = &jobs;
+  Pipeline::pending = 0;
+
+  for(size_t i = 0; i < Pipeline::stages.size(); i++) {
+    Pipeline::remaining[i] = Pipeline::stages[i].dependencies;
+  }
+
+  for(size_t i = 0; i < Pipeline::stages.size(); i++) {
+    if(Pipeline::stages[i].dependencies == 0) {
+      Pipeline::start(i);
+    }
+  }
+
+  jobs.wait(Pipeline::pending);
+}
+
+
+/// @brief Clears the accumulated timings
+void Pipeline::reset_timings()
+{
+  for(Stage &stage: Pipeline::stages) {
+    stage.last_time = 0;
+    stage.total_time = 0;
+    stage.runs = 0;
+    stage.counters = {};
+    stage.allocations = {};
+  }
+}
+
+
+// Getters===========
+size_t Pipeline::get_stage_count() const
+{
+  return Pipeline::stages.size();
+}
+
+const std::string &Pipeline::get_stage_name(size_t stage) const
+{
+  return Pipeline::stages[stage].name;
+}
+
+double Pipeline::get_last_time(size_t stage) const
+{
+  return Pipeline::stages[stage].last_time;
+}
+
+double Pipeline::get_mean_time(size_t stage) const
+{
+  const Stage &s = Pipeline::stages[stage];
+  return s.runs > 0 ? s.total_time / s.runs : 0;
+}
+
+long Pipeline::get_runs(size_t stage) const
+{
+  return Pipeline::stages[stage].runs;
+}
+
+const PerfSample &Pipeline::get_counters(size_t stage) const
+{
+  return Pipeline::stages[stage].counters;
+}
+
+const AllocStats &Pipeline::get_allocations(size_t stage) const
+{
+  return Pipeline::stages[stage].allocations;
+}
+
+
+// Setters===========
+void Pipeline::set_trace(TraceLog *trace)
+{
+  Pipeline::trace = trace;
+}
+
+void Pipeline::set_counting(bool counting)
+{
+  Pipeline::counting = counting;
+}
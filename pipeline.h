@@ -0,0 +1,73 @@
+#ifndef pipeline_h
+#define pipeline_h
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include "job_system.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "alloc_tracker.h"
+
+/// @brief Named stages run in declaration order unless they touch disjoint state.
+/// Each stage declares the state it reads and writes (bit masks); a stage waits for every
+/// earlier stage it conflicts with (write/read, read/write or write/write), the others
+/// run concurrently on the job system. The results never depend on the thread count
+class Pipeline {
+
+  // Private by default
+  struct Stage {
+    std::string name;
+    uint32_t reads;
+    uint32_t writes;
+    std::function<void()> run;
+    std::vector<size_t> dependents = {};
+    size_t dependencies = 0;
+
+    // Timings (ms)
+    double last_time = 0;
+    double total_time = 0;
+    long runs = 0;
+
+    // Hardware counters of the thread running the stage (summed over runs)
+    PerfSample counters = {};
+
+    // Heap activity of the thread running the stage (profiling builds)
+    AllocStats allocations = {};
+  };
+
+  std::vector<Stage> stages = {};
+  std::unique_ptr<std::atomic<size_t>[]> remaining = nullptr;  // unfinished dependencies per stage
+  TraceLog *trace = nullptr;                                     // records the stages run, if set
+  bool counting = false;                                         // reads hardware counters around stages
+
+  // Running pass (kept here so stage tasks only capture the stage index)
+  JobSystem *jobs = nullptr;
+  std::atomic<size_t> pending{0};
+
+  void start(size_t stage);
+
+  public:
+    Pipeline(){}
+    void add_stage(const std::string &name, uint32_t reads, uint32_t writes, std::function<void()> run);
+    void run(JobSystem &jobs);
+    void reset_timings();
+
+    // getters
+    size_t get_stage_count() const;
+    const std::string &get_stage_name(size_t stage) const;
+    double get_last_time(size_t stage) const;
+    double get_mean_time(size_t stage) const;
+    long get_runs(size_t stage) const;
+    const PerfSample &get_counters(size_t stage) const;
+    const AllocStats &get_allocations(size_t stage) const;
+
+    // setters
+    void set_trace(TraceLog *trace);
+    void set_counting(bool counting);
+};
+
+#endif
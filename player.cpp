@@ -1,6 +1,7 @@
 #include "player.h"
 #include <cmath>
 #include <iostream>
+#include <algorithm>
 
 
 //==============================================
@@ -13,6 +14,8 @@ void Player::setup(const svg_tools::Circ &circle)
 
   Player::initial_cx = cx;
   Player::initial_cy = cy;
+  Player::previous_cx = cx;
+  Player::previous_cy = cy;
 
   //legs========
   Player::legs_height = circle.r * 2 * LEGS_PROP;
@@ -132,10 +135,14 @@ void Player::draw_leg(double x, double y, double theta1, double theta2, double z
 
 //======================
 // Draw whole body
-void Player::draw() const
+// alpha interpolates between the previous and the current simulation step
+void Player::draw(double alpha) const
 {
+  double x = Player::previous_cx + (Player::cx - Player::previous_cx) * alpha;
+  double y = Player::previous_cy + (Player::cy - Player::previous_cy) * alpha;
+
   glPushMatrix();
-    glTranslated(Player::cx, Player::cy, 0);
+    glTranslated(x, y, 0);
     Player::draw_trunk(PLAYER_Z_INDEX ,GREEN);
     Player::draw_head(
       0, -((Player::trunk_height/2) + (Player::head_diameter/2)), PLAYER_Z_INDEX, GREEN
@@ -214,6 +221,15 @@ void Player::walk(double time_diff, HorizontalMoveDirection direction)
 }
 
 
+//=============================================
+// Keeps current position for render interpolation
+void Player::store_previous_state()
+{
+  Player::previous_cx = Player::cx;
+  Player::previous_cy = Player::cy;
+}
+
+
 //================================
 // Set leg angles to 0
 void Player::reset_legs_position()
@@ -226,8 +242,8 @@ void Player::reset_legs_position()
 
 
 //===========================================================================
-// Jump motion
-int Player::jump(double time_diff, double acc ,int button_state, bool collide)
+// Jump motion, moving at most room_up upward or room_down downward (free distances to the first contact)
+int Player::jump(double time_diff, double acc ,int button_state, double room_up, double room_down)
 {
   // Calculating rise and fall velocity
   // v = v0 + at
@@ -246,27 +262,27 @@ int Player::jump(double time_diff, double acc ,int button_state, bool collide)
 
   // Rising
   if(button_state == 1 and jump_phase == JumpPhase::Up) {
-    if(rise_velocity <= 0 or collide){
+    if(rise_velocity <= 0 or room_up <= 0){
       jump_phase = JumpPhase::Down;
       jump_time = 0.0;
       return 1;
     }
 
     // Rising up
-    Player::cy -= time_diff * rise_velocity;
+    Player::cy -= std::min(time_diff * rise_velocity, room_up);
     jump_button_last_state = 1;
   }
 
   // Falling
   else if(Player::jump_phase == JumpPhase::Down) {
-    if(Player::cy >= Player::initial_cy or collide) {
+    if(Player::cy >= Player::initial_cy or room_down <= 0) {
       jump_phase = JumpPhase::Up;
       jump_time = 0.0;
       return 0;
     }
 
     // Falling down
-    Player::cy += time_diff * fall_velocity;
+    Player::cy += std::min(time_diff * fall_velocity, room_down);
   }
 
   // Updating jump time
@@ -277,28 +293,38 @@ int Player::jump(double time_diff, double acc ,int button_state, bool collide)
 
 
 //=========================================================
-// Fall motion
-int Player::fall(double time_diff, double acc, bool collide)
+// Fall motion, moving at most room_down (free distance to the first contact)
+int Player::fall(double time_diff, double acc, double room_down)
 {
   // double acc = 9.8;
   double correction_factor = CORRECT_FACTOR;
   double fall_velocity = (0 + (acc * fall_time /correction_factor));
 
-  if(Player::cy >= Player::initial_cy or collide) {
+  if(Player::cy >= Player::initial_cy or room_down <= 0) {
     // Restarting fall time
     fall_time = 0.0;
     return 0;
   }
 
-  Player::cy += time_diff * fall_velocity; 
+  Player::cy += std::min(time_diff * fall_velocity, room_down);
   Player::fall_time += time_diff;
   Player::reset_legs_position();
   return 1;  
 }
 
 
+//=========================================================
+// Farthest vertical displacement of the next jump or fall step (range to sweep for contacts)
+double Player::get_vertical_reach(double time_diff, double acc) const
+{
+  double correction_factor = CORRECT_FACTOR;
+  double fall_velocity = acc * std::max(Player::jump_time, Player::fall_time) / correction_factor;
+  return time_diff * std::max(Player::jump_velocity, fall_velocity);
+}
+
+
 // Getters=======================
-JumpPhase Player::get_jump_phase()
+JumpPhase Player::get_jump_phase() const
 {
   return Player::jump_phase;
 }
@@ -323,31 +349,41 @@ double Player::get_bottom_edge() const
   return Player::cy + (Player::height/2);
 }
 
-double Player::get_velocity()
+double Player::get_velocity() const
 {
   return Player::velocity;
 }
 
-double Player::get_cy()
+double Player::get_cy() const
 {
   return Player::cy;
 }
 
-double Player::get_cx()
+double Player::get_cx() const
 {
   return Player::cx;
 }
 
-double Player::get_initial_cx()
+double Player::get_initial_cx() const
 {
   return Player::initial_cx;
 }
 
-HorizontalMoveDirection Player::get_walk_direction()
+HorizontalMoveDirection Player::get_walk_direction() const
 {
     return Player::walk_direction;
 }
 
+int Player::get_proxy() const
+{
+  return Player::proxy;
+}
+
+uint32_t Player::get_id() const
+{
+  return Player::id;
+}
+
 
 //Setters===============================
 void Player::set_arm_angle(double angle)
@@ -386,6 +422,16 @@ void Player::set_arm_angle_base(double angle)
   Player::arms_angle_base = angle;
 }
 
+void Player::set_proxy(int proxy)
+{
+  Player::proxy = proxy;
+}
+
+void Player::set_id(uint32_t id)
+{
+  Player::id = id;
+}
+
 void Player::set_cy(double cy)
 {
   Player::cy = cy;
@@ -413,7 +459,7 @@ void Player::set_velocity(double velocity)
 
 // External==================
 // Instantiate a new shot
-Shot *Player::shoot()
+Shot Player::shoot() const
 {
   // Tip of the arm
   double arm_tip[2] = { 0, Player::arms_height };
@@ -431,5 +477,5 @@ Shot *Player::shoot()
   double direction_vector_norm = sqrt(pow(direction_vector[0], 2) + pow(direction_vector[1], 2));
   double normalized_vector[2] = { (direction_vector[0]/direction_vector_norm), (direction_vector[1]/direction_vector_norm) };
 
-  return new Shot(arm_tip, normalized_vector);
+  return Shot(arm_tip, normalized_vector);
 }
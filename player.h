@@ -4,6 +4,7 @@
 #include <GL/glu.h>
 #include <GL/gl.h>
 #include <array>
+#include <cstdint>
 
 #include "utils.h"
 #include "shot.h"
@@ -30,6 +31,10 @@ class Player {
   // Private
   double cx = 0;  // centroid
   double cy = 0;
+  double previous_cx = 0;  // centroid at the previous simulation step
+  double previous_cy = 0;
+  int proxy = -1;          // broadphase proxy id
+  uint32_t id = 0;         // stable while alive (keys the entity random streams)
   double height;
   double velocity = 0.05;
   double jump_velocity = 0.075;
@@ -86,29 +91,34 @@ class Player {
   public:
     Player(){}
     void setup(const svg_tools::Circ &circle);
-    void draw() const;
+    void draw(double alpha = 1.0) const;
+    void store_previous_state();
     
     // walk control
     void walk(double time_diff, HorizontalMoveDirection direction);
     void reset_legs_position();
 
     // fall control
-    int fall(double time_diff, double acc, bool collide);
+    int fall(double time_diff, double acc, double room_down);
     
     // jump control
-    int jump(double time_diff, double acc, int button_state, bool collide);
+    int jump(double time_diff, double acc, int button_state, double room_up, double room_down);
+
+    double get_vertical_reach(double time_diff, double acc) const;
 
     // getters
-    double get_cx();
-    double get_cy();
-    double get_velocity();
-    double get_initial_cx();
-    JumpPhase get_jump_phase();
+    double get_cx() const;
+    double get_cy() const;
+    double get_velocity() const;
+    double get_initial_cx() const;
+    JumpPhase get_jump_phase() const;
     double get_top_edge() const;
     double get_left_edge() const;
     double get_right_edge() const;
     double get_bottom_edge() const;
-    HorizontalMoveDirection get_walk_direction();
+    HorizontalMoveDirection get_walk_direction() const;
+    int get_proxy() const;
+    uint32_t get_id() const;
 
     // setters
     void set_cx(double cx);
@@ -117,9 +127,11 @@ class Player {
     void set_arm_angle(double angle);
     void set_velocity(double velocity);
     void set_arm_angle_base(double angle);
+    void set_proxy(int proxy);
+    void set_id(uint32_t id);
     
     // external items
-    Shot * shoot();
+    Shot shoot() const;
 };
 
 #endif
@@ -0,0 +1,120 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+
+
+/// @brief Appends a section (sections are added before the first frame)
+/// @param name shown with the timings
+/// @return index of the section
+size_t FrameProfiler::add_section(const std::string &name)
+{
+  Section section;
+  section.name = name;
+  section.samples.assign(PROFILER_WINDOW, 0);
+  FrameProfiler::sections.push_back(std::move(section));
+  FrameProfiler::scratch.resize(PROFILER_WINDOW);
+  return FrameProfiler::sections.size() - 1;
+}
+
+
+/// @brief Adds time spent in a section to the running frame
+/// @param section
+/// @param ms
+void FrameProfiler::add(size_t section, double ms)
+{
+  FrameProfiler::sections[section].frame_time += ms;
+}
+
+
+/// @brief Closes the running frame: each section gets one sample
+/// (0 if it did not run in the frame)
+void FrameProfiler::end_frame()
+{
+  for(Section &section: FrameProfiler::sections) {
+    section.samples[FrameProfiler::next] = section.frame_time;
+    section.frame_time = 0;
+  }
+
+  FrameProfiler::next = (FrameProfiler::next + 1) % PROFILER_WINDOW;
+  FrameProfiler::count = std::min(FrameProfiler::count + 1, (size_t)PROFILER_WINDOW);
+}
+
+
+/// @brief Drops every sample, keeping the sections
+void FrameProfiler::reset()
+{
+  for(Section &section: FrameProfiler::sections) {
+    section.frame_time = 0;
+    std::fill(section.samples.begin(), section.samples.end(), 0);
+  }
+  FrameProfiler::next = 0;
+  FrameProfiler::count = 0;
+}
+
+
+// Getters===========
+size_t FrameProfiler::get_section_count() const
+{
+  return FrameProfiler::sections.size();
+}
+
+const std::string &FrameProfiler::get_section_name(size_t section) const
+{
+  return FrameProfiler::sections[section].name;
+}
+
+size_t FrameProfiler::get_frame_count() const
+{
+  return FrameProfiler::count;
+}
+
+double FrameProfiler::get_min(size_t section) const
+{
+  const std::vector<double> &samples = FrameProfiler::sections[section].samples;
+  if(FrameProfiler::count == 0) return 0;
+  return *std::min_element(samples.begin(), samples.begin() + FrameProfiler::count);
+}
+
+double FrameProfiler::get_mean(size_t section) const
+{
+  const std::vector<double> &samples = FrameProfiler::sections[section].samples;
+  if(FrameProfiler::count == 0) return 0;
+
+  double sum = 0;
+  for(size_t i = 0; i < FrameProfiler::count; i++) sum += samples[i];
+  return sum / FrameProfiler::count;
+}
+
+/// @brief Nearest-rank percentile over the window
+/// @param section
+/// @param percentile in [0, 100]
+double FrameProfiler::get_percentile(size_t section, double percentile) const
+{
+  const std::vector<double> &samples = FrameProfiler::sections[section].samples;
+  if(FrameProfiler::count == 0) return 0;
+
+  size_t rank = (size_t)std::ceil(percentile / 100 * FrameProfiler::count);
+  rank = std::min(std::max(rank, (size_t)1), FrameProfiler::count) - 1;
+
+  std::copy(samples.begin(), samples.begin() + FrameProfiler::count, FrameProfiler::scratch.begin());
+  std::nth_element(FrameProfiler::scratch.begin(), FrameProfiler::scratch.begin() + rank, FrameProfiler::scratch.begin() + FrameProfiler::count);
+  return FrameProfiler::scratch[rank];
+}
+
+
+//==========================================
+// Starts timing a section
+ScopedTimer::ScopedTimer(FrameProfiler &profiler, size_t section) : profiler(profiler)
+{
+  ScopedTimer::section = section;
+  ScopedTimer::start = std::chrono::steady_clock::now();
+}
+
+
+//==========================================
+// Adds the elapsed time to the section
+ScopedTimer::~ScopedTimer()
+{
+  auto end = std::chrono::steady_clock::now();
+  ScopedTimer::profiler.add(ScopedTimer::section, std::chrono::duration<double, std::milli>(end - ScopedTimer::start).count());
+}
@@ -0,0 +1,60 @@
+#ifndef profiler_h
+#define profiler_h
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstddef>
+
+// Frames kept per section
+#define PROFILER_WINDOW 240
+
+/// @brief Rolling per-frame timings of named sections.
+/// Time spent in a section is accumulated during a frame (a section may run several
+/// times per frame, e.g. one tick stage per simulation step) and becomes one sample
+/// when the frame ends; min, mean and percentiles are taken over the last
+/// PROFILER_WINDOW frames. Samples live in fixed ring buffers, nothing is allocated per frame
+class FrameProfiler {
+
+  // Private by default
+  struct Section {
+    std::string name;
+    double frame_time = 0;          // accumulated in the running frame (ms)
+    std::vector<double> samples = {};
+  };
+
+  std::vector<Section> sections = {};
+  mutable std::vector<double> scratch = {};  // sorted copy for percentiles
+  size_t next = 0;                           // ring position of the next sample
+  size_t count = 0;                          // samples in the window
+
+  public:
+    FrameProfiler(){}
+    size_t add_section(const std::string &name);
+    void add(size_t section, double ms);
+    void end_frame();
+    void reset();
+
+    // getters
+    size_t get_section_count() const;
+    const std::string &get_section_name(size_t section) const;
+    size_t get_frame_count() const;
+    double get_min(size_t section) const;
+    double get_mean(size_t section) const;
+    double get_percentile(size_t section, double percentile) const;
+};
+
+/// @brief Adds the time between its construction and destruction to a section
+class ScopedTimer {
+
+  // Private by default
+  FrameProfiler &profiler;
+  size_t section;
+  std::chrono::steady_clock::time_point start;
+
+  public:
+    ScopedTimer(FrameProfiler &profiler, size_t section);
+    ~ScopedTimer();
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "rng.h"
+
+
+//==========================================
+// SplitMix64 finalizer (bijective 64 bits mixer)
+static uint64_t mix(uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+/// @brief Number `counter` of a stream (pure function of seed, stream and counter)
+/// @param stream
+/// @param counter
+/// @return 64 random bits
+uint64_t Rng::get(uint64_t stream, uint64_t counter) const
+{
+  uint64_t key = mix(Rng::seed + stream * 0x9E3779B97F4A7C15ULL);
+  return mix(key ^ mix(counter + 0x632BE59BD9B4E019ULL));
+}
+
+
+// Getters===========
+uint64_t Rng::get_seed() const
+{
+  return Rng::seed;
+}
+
+
+// Setters===========
+void Rng::set_seed(uint64_t seed)
+{
+  Rng::seed = seed;
+}
+
+
+//==========================================
+// Stream of the given id, starting at its first number
+RngStream::RngStream(const Rng &rng, uint64_t stream)
+{
+  RngStream::rng = &rng;
+  RngStream::stream = stream;
+  RngStream::counter = 0;
+}
+
+
+/// @brief Stream of one entity of a kind, starting at number `counter`. Keying draws on
+/// (counter = tick, entity) makes them independent of the order entities are updated in
+/// and of how many numbers other entities or earlier ticks drew
+/// @param rng
+/// @param kind stream id of the entity kind
+/// @param entity
+/// @param counter first number drawn
+RngStream::RngStream(const Rng &rng, uint64_t kind, uint32_t entity, uint64_t counter)
+{
+  RngStream::rng = &rng;
+  RngStream::stream = ((kind + 1) << 32) | entity;  // above every system stream
+  RngStream::counter = counter;
+}
+
+
+/// @brief Next 64 random bits
+uint64_t RngStream::next()
+{
+  return RngStream::rng->get(RngStream::stream, RngStream::counter++);
+}
+
+
+/// @brief Next number uniform in [min, max)
+/// @param min
+/// @param max
+double RngStream::next_uniform(double min, double max)
+{
+  double unit = (RngStream::next() >> 11) * 0x1.0p-53;  // 53 bits mantissa
+  return min + (max - min) * unit;
+}
+
+
+/// @brief Next integer uniform in [0, n) (n > 0)
+/// @param n
+uint64_t RngStream::next_below(uint64_t n)
+{
+  // Multiply-shift keeps the bias below n / 2^64
+  return (uint64_t)(((unsigned __int128)RngStream::next() * n) >> 64);
+}
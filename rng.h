@@ -0,0 +1,49 @@
+#ifndef rng_h
+#define rng_h
+
+#include <cstdint>
+
+// Stream ids of the game systems. Per entity kinds (e.g. EnemyFireStream) are keyed with
+// the entity id too, giving each entity its own stream (see RngStream)
+enum RngStreamId {
+  EnemyFireStream,
+  BulletHellStream
+};
+
+/// @brief Counter-based random numbers: the value is a hash of (seed, stream, counter).
+/// Streams are independent and need no state besides their counter, so any entity can
+/// own one for free and a whole run is reproduced from the seed alone
+class Rng {
+
+  // Private by default
+  uint64_t seed = 0;
+
+  public:
+    Rng(){}
+    uint64_t get(uint64_t stream, uint64_t counter) const;
+
+    // getters
+    uint64_t get_seed() const;
+
+    // setters
+    void set_seed(uint64_t seed);
+};
+
+/// @brief Sequence of numbers of one stream
+class RngStream {
+
+  // Private by default
+  const Rng *rng = nullptr;
+  uint64_t stream = 0;
+  uint64_t counter = 0;
+
+  public:
+    RngStream(){}
+    RngStream(const Rng &rng, uint64_t stream);
+    RngStream(const Rng &rng, uint64_t kind, uint32_t entity, uint64_t counter);
+    uint64_t next();
+    double next_uniform(double min, double max);
+    uint64_t next_below(uint64_t n);
+};
+
+#endif
@@ -2,14 +2,12 @@
 #include <math.h>
 #include <iostream>
 
-#define DISTANCIA_MAX 370
+#define SHOT_RADIUS 1
 
 //===================================================
 // Constructor
 Shot::Shot(double init_point[2], double direct_vec[2])
 {
-  Shot::x_initial = init_point[0]; 
-  Shot::y_initial = init_point[1]; 
   Shot::x = init_point[0]; 
   Shot::y = init_point[1];
   // gDirectionAng = directionAng; 
@@ -34,43 +32,31 @@ void Shot::draw_circle(double radius, double R, double G, double B)
 }
 
 
-void Shot::draw()
+//=============================
+// Draws a shot at (x, y)
+void Shot::draw(double x, double y)
 {
   glPushMatrix();
-    glTranslatef(Shot::x, Shot::y, 0);
-    Shot::draw_circle(Shot::radius, 1, 1, 1);  
+    glTranslatef(x, y, 0);
+    Shot::draw_circle(SHOT_RADIUS, 1, 1, 1);  
   glPopMatrix();
 }
 
 
-//==============================
-// Shot motion
-void Shot::move(double timeDiff)
+//Getters====================
+void Shot::get_pos(double &x_out, double &y_out) const
 {
-  double aux_vec[2] = { 
-    Shot::direction_vector[0] * Shot::velocity * timeDiff,   // Distance = velocity * time
-    Shot::direction_vector[1] * Shot::velocity * timeDiff 
-  };
-
-  x += aux_vec[0];
-  y += aux_vec[1];
+  x_out = Shot::x;
+  y_out = Shot::y;
 }
 
-
-bool Shot::is_valid()
+void Shot::get_direction(double &x_out, double &y_out) const
 {
-  return !(
-    Shot::x > DISTANCIA_MAX or 
-    Shot::y > DISTANCIA_MAX or
-    Shot::x < -DISTANCIA_MAX or
-    Shot::y < - DISTANCIA_MAX
-  );
+  x_out = Shot::direction_vector[0];
+  y_out = Shot::direction_vector[1];
 }
 
-
-//Getters====================
-void Shot::get_pos(double &x_out, double &y_out)
+double Shot::get_velocity() const
 {
-  x_out = Shot::x;
-  y_out = Shot::y;
+  return Shot::velocity;
 }
@@ -4,27 +4,26 @@
 #include <GL/glu.h>
 #include <GL/gl.h>
 
+/// @brief Initial state of a shot. Live shots are stored by ShotPool
 class Shot {
     double x; 
     double y; 
-    double x_initial; 
-    double y_initial; 
     // double gDirectionAng;
-    double radius = 1;
     double velocity = 0.1;
     double direction_vector[2];
 
 private:
-    void draw_circle(double radius, double R, double G, double B);
+    static void draw_circle(double radius, double R, double G, double B);
 
 public:
+    Shot(){}
     Shot(double init_point[2], double direct_vec[2]);
-    void draw();
-    void move(double timeDiff);
-    bool is_valid();
+    static void draw(double x, double y);
     
     // getters
-    void get_pos(double &x_out, double &y_out);
+    void get_pos(double &x_out, double &y_out) const;
+    void get_direction(double &x_out, double &y_out) const;
+    double get_velocity() const;
 };
 
 #endif
@@ -0,0 +1,308 @@
+#include "shot_pool.h"
+#include <immintrin.h>
+#include <algorithm>
+
+
+//==============================================================================
+// Motion and bounds kernels: x += direction * velocity * timeDiff, then
+// expired = out of bounds (min x, min y, max x, max y). Both produce the same results
+static void integrate_scalar(
+  double *x, double *y, const double *dir_x, const double *dir_y, const double *velocity,
+  uint8_t *expired, size_t begin, size_t end, double timeDiff, const double *bounds)
+{
+  for(size_t i = begin; i < end; i++) {
+    x[i] += dir_x[i] * velocity[i] * timeDiff;   // Distance = velocity * time
+    y[i] += dir_y[i] * velocity[i] * timeDiff;
+
+    expired[i] = 
+      x[i] > bounds[2] or 
+      y[i] > bounds[3] or
+      x[i] < bounds[0] or
+      y[i] < bounds[1];
+  }
+}
+
+__attribute__((target("avx2")))
+static void integrate_avx2(
+  double *x, double *y, const double *dir_x, const double *dir_y, const double *velocity,
+  uint8_t *expired, size_t count, double timeDiff, const double *bounds)
+{
+  const __m256d dt = _mm256_set1_pd(timeDiff);
+  const __m256d min_x = _mm256_set1_pd(bounds[0]);
+  const __m256d min_y = _mm256_set1_pd(bounds[1]);
+  const __m256d max_x = _mm256_set1_pd(bounds[2]);
+  const __m256d max_y = _mm256_set1_pd(bounds[3]);
+  size_t i = 0;
+
+  // 4 shots per iteration
+  for(; i + 4 <= count; i += 4) {
+    __m256d v = _mm256_loadu_pd(velocity + i);
+    __m256d px = _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(dir_x + i), v), dt));
+    __m256d py = _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(dir_y + i), v), dt));
+    _mm256_storeu_pd(x + i, px);
+    _mm256_storeu_pd(y + i, py);
+
+    __m256d out = _mm256_or_pd(
+      _mm256_or_pd(_mm256_cmp_pd(px, max_x, _CMP_GT_OQ), _mm256_cmp_pd(py, max_y, _CMP_GT_OQ)),
+      _mm256_or_pd(_mm256_cmp_pd(px, min_x, _CMP_LT_OQ), _mm256_cmp_pd(py, min_y, _CMP_LT_OQ))
+    );
+
+    int mask = _mm256_movemask_pd(out);
+    expired[i] = mask & 1;
+    expired[i + 1] = (mask >> 1) & 1;
+    expired[i + 2] = (mask >> 2) & 1;
+    expired[i + 3] = (mask >> 3) & 1;
+  }
+
+  // Remaining shots
+  integrate_scalar(x, y, dir_x, dir_y, velocity, expired, i, count, timeDiff, bounds);
+}
+
+
+/// @brief Allocates every slot up front (no allocation while playing)
+/// @param capacity 
+void ShotPool::setup(size_t capacity)
+{
+  ShotPool::x.assign(capacity, 0);
+  ShotPool::y.assign(capacity, 0);
+  ShotPool::previous_x.assign(capacity, 0);
+  ShotPool::previous_y.assign(capacity, 0);
+  ShotPool::direction_x.assign(capacity, 0);
+  ShotPool::direction_y.assign(capacity, 0);
+  ShotPool::velocity.assign(capacity, 0);
+  ShotPool::expired.assign(capacity, 0);
+  ShotPool::dead.assign(capacity, 0);
+  ShotPool::count = 0;
+  ShotPool::peak = 0;
+  ShotPool::dropped = 0;
+}
+
+
+/// @brief Appends a copy of the shot
+/// @param shot 
+/// @return false if the pool is full (the shot is dropped)
+bool ShotPool::spawn(const Shot &shot)
+{
+  if(ShotPool::count == ShotPool::get_capacity()) {
+    ShotPool::dropped++;
+    return false;
+  }
+
+  // Dense entry
+  size_t i = ShotPool::count++;
+  shot.get_pos(ShotPool::x[i], ShotPool::y[i]);
+  shot.get_direction(ShotPool::direction_x[i], ShotPool::direction_y[i]);
+  ShotPool::previous_x[i] = ShotPool::x[i];
+  ShotPool::previous_y[i] = ShotPool::y[i];
+  ShotPool::velocity[i] = shot.get_velocity();
+  ShotPool::expired[i] = 0;
+  ShotPool::dead[i] = 0;
+
+  if(ShotPool::count > ShotPool::peak) {
+    ShotPool::peak = ShotPool::count;
+  }
+  return true;
+}
+
+
+/// @brief Marks the i-th live shot for removal
+/// @param i 
+void ShotPool::kill(size_t i)
+{
+  ShotPool::dead[i] = 1;
+}
+
+
+/// @brief Removes the marked shots keeping creation order
+void ShotPool::compact()
+{
+  size_t kept = 0;
+
+  for(size_t i = 0; i < ShotPool::count; i++) {
+    if(ShotPool::dead[i]) continue;
+
+    if(kept != i) {
+      ShotPool::x[kept] = ShotPool::x[i];
+      ShotPool::y[kept] = ShotPool::y[i];
+      ShotPool::previous_x[kept] = ShotPool::previous_x[i];
+      ShotPool::previous_y[kept] = ShotPool::previous_y[i];
+      ShotPool::direction_x[kept] = ShotPool::direction_x[i];
+      ShotPool::direction_y[kept] = ShotPool::direction_y[i];
+      ShotPool::velocity[kept] = ShotPool::velocity[i];
+      ShotPool::expired[kept] = ShotPool::expired[i];
+      ShotPool::dead[kept] = 0;
+    }
+    kept++;
+  }
+
+  ShotPool::count = kept;
+}
+
+
+/// @brief Releases every shot (statistics are kept)
+void ShotPool::clear()
+{
+  ShotPool::count = 0;
+}
+
+
+/// @brief Copies the live shots into a snapshot
+/// (statistics are not part of the state)
+/// @param snapshot
+void ShotPool::save(Snapshot &snapshot) const
+{
+  size_t n = ShotPool::count;
+
+  snapshot.put(n);
+  snapshot.write(ShotPool::x.data(), n * sizeof(double));
+  snapshot.write(ShotPool::y.data(), n * sizeof(double));
+  snapshot.write(ShotPool::previous_x.data(), n * sizeof(double));
+  snapshot.write(ShotPool::previous_y.data(), n * sizeof(double));
+  snapshot.write(ShotPool::direction_x.data(), n * sizeof(double));
+  snapshot.write(ShotPool::direction_y.data(), n * sizeof(double));
+  snapshot.write(ShotPool::velocity.data(), n * sizeof(double));
+  snapshot.write(ShotPool::expired.data(), n * sizeof(uint8_t));
+  snapshot.write(ShotPool::dead.data(), n * sizeof(uint8_t));
+}
+
+
+/// @brief Reads back what save() wrote (no allocation).
+/// The peak and dropped statistics keep counting across restores
+/// @param snapshot
+/// @return false if the shots do not fit this pool or the snapshot ends early
+/// (the pool is left empty and the snapshot is past the shots either way)
+bool ShotPool::restore(Snapshot &snapshot)
+{
+  size_t n = 0;
+
+  snapshot.get(n);
+  if(n > ShotPool::get_capacity()) {
+    // Bytes per shot, as written by save() (a corrupted count overruns)
+    size_t shot_bytes = 7 * sizeof(double) + 2 * sizeof(uint8_t);
+    snapshot.skip(n > snapshot.remaining() / shot_bytes ? snapshot.remaining() + 1 : n * shot_bytes);
+    ShotPool::clear();
+    return false;
+  }
+
+  snapshot.read(ShotPool::x.data(), n * sizeof(double));
+  snapshot.read(ShotPool::y.data(), n * sizeof(double));
+  snapshot.read(ShotPool::previous_x.data(), n * sizeof(double));
+  snapshot.read(ShotPool::previous_y.data(), n * sizeof(double));
+  snapshot.read(ShotPool::direction_x.data(), n * sizeof(double));
+  snapshot.read(ShotPool::direction_y.data(), n * sizeof(double));
+  snapshot.read(ShotPool::velocity.data(), n * sizeof(double));
+  snapshot.read(ShotPool::expired.data(), n * sizeof(uint8_t));
+  snapshot.read(ShotPool::dead.data(), n * sizeof(uint8_t));
+
+  if(snapshot.is_overrun()) {
+    ShotPool::clear();
+    return false;
+  }
+
+  ShotPool::count = n;
+
+  ShotPool::peak = std::max(ShotPool::peak, n);
+  return true;
+}
+
+
+/// @brief Moves every live shot and flags those leaving the world
+/// @param timeDiff 
+void ShotPool::integrate(double timeDiff)
+{
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+
+  if(ShotPool::simd && has_avx2) {
+    integrate_avx2(
+      ShotPool::x.data(), ShotPool::y.data(), ShotPool::direction_x.data(), ShotPool::direction_y.data(),
+      ShotPool::velocity.data(), ShotPool::expired.data(), ShotPool::count, timeDiff, ShotPool::bounds
+    );
+    return;
+  }
+
+  integrate_scalar(
+    ShotPool::x.data(), ShotPool::y.data(), ShotPool::direction_x.data(), ShotPool::direction_y.data(),
+    ShotPool::velocity.data(), ShotPool::expired.data(), 0, ShotPool::count, timeDiff, ShotPool::bounds
+  );
+}
+
+
+/// @brief Keeps current positions for render interpolation
+void ShotPool::store_previous_state()
+{
+  std::copy(ShotPool::x.begin(), ShotPool::x.begin() + ShotPool::count, ShotPool::previous_x.begin());
+  std::copy(ShotPool::y.begin(), ShotPool::y.begin() + ShotPool::count, ShotPool::previous_y.begin());
+}
+
+
+// Getters===========
+size_t ShotPool::size() const
+{
+  return ShotPool::count;
+}
+
+const double *ShotPool::get_xs() const
+{
+  return ShotPool::x.data();
+}
+
+const double *ShotPool::get_ys() const
+{
+  return ShotPool::y.data();
+}
+
+const double *ShotPool::get_previous_xs() const
+{
+  return ShotPool::previous_x.data();
+}
+
+const double *ShotPool::get_previous_ys() const
+{
+  return ShotPool::previous_y.data();
+}
+
+bool ShotPool::is_expired(size_t i) const
+{
+  return ShotPool::expired[i];
+}
+
+bool ShotPool::is_dead(size_t i) const
+{
+  return ShotPool::dead[i];
+}
+
+size_t ShotPool::get_capacity() const
+{
+  return ShotPool::x.size();
+}
+
+size_t ShotPool::get_peak() const
+{
+  return ShotPool::peak;
+}
+
+size_t ShotPool::get_dropped() const
+{
+  return ShotPool::dropped;
+}
+
+bool ShotPool::get_simd() const
+{
+  return ShotPool::simd;
+}
+
+
+// Setters===========
+void ShotPool::set_simd(bool enabled)
+{
+  ShotPool::simd = enabled;
+}
+
+/// @brief Box outside which shots expire (nothing can be hit out there)
+void ShotPool::set_bounds(double min_x, double min_y, double max_x, double max_y)
+{
+  ShotPool::bounds[0] = min_x;
+  ShotPool::bounds[1] = min_y;
+  ShotPool::bounds[2] = max_x;
+  ShotPool::bounds[3] = max_y;
+}
@@ -0,0 +1,72 @@
+#ifndef shot_pool_h
+#define shot_pool_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include "shot.h"
+#include "snapshot.h"
+
+// Default number of shots alive at the same time
+#define SHOT_POOL_CAPACITY 4096
+
+/// @brief Fixed-capacity shot storage.
+/// Live shots are packed as structure of arrays in creation order and updated in batches.
+/// Shots are only addressed by their index within a tick (nothing keeps a shot across ticks)
+class ShotPool {
+
+  // Private by default
+  // Dense storage (one entry per live shot)================
+  std::vector<double> x = {};
+  std::vector<double> y = {};
+  std::vector<double> previous_x = {};  // position at the previous simulation step
+  std::vector<double> previous_y = {};
+  std::vector<double> direction_x = {};
+  std::vector<double> direction_y = {};
+  std::vector<double> velocity = {};
+  std::vector<uint8_t> expired = {};     // left the world in the last integrate()
+  std::vector<uint8_t> dead = {};        // removed on the next compact()
+  size_t count = 0;
+
+  // Shots leaving this box expire (min x, min y, max x, max y)
+  double bounds[4] = { -HUGE_VAL, -HUGE_VAL, HUGE_VAL, HUGE_VAL };
+
+  // Statistics
+  size_t peak = 0;
+  size_t dropped = 0;
+  bool simd = true;
+
+  public:
+    ShotPool(){}
+    void setup(size_t capacity);
+    bool spawn(const Shot &shot);
+    void kill(size_t i);
+    void compact();
+    void clear();
+    void save(Snapshot &snapshot) const;
+    bool restore(Snapshot &snapshot);
+
+    // batch updates
+    void integrate(double timeDiff);
+    void store_previous_state();
+
+    // getters
+    size_t size() const;
+    const double *get_xs() const;
+    const double *get_ys() const;
+    const double *get_previous_xs() const;
+    const double *get_previous_ys() const;
+    bool is_expired(size_t i) const;
+    bool is_dead(size_t i) const;
+    size_t get_capacity() const;
+    size_t get_peak() const;
+    size_t get_dropped() const;
+    bool get_simd() const;
+
+    // setters
+    void set_simd(bool enabled);
+    void set_bounds(double min_x, double min_y, double max_x, double max_y);
+};
+
+#endif
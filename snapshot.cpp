@@ -0,0 +1,114 @@
+#include "snapshot.h"
+#include <algorithm>
+
+
+/// @brief Starts a new snapshot (keeps the storage)
+void Snapshot::clear()
+{
+  Snapshot::source = nullptr;
+  Snapshot::used = 0;
+  Snapshot::cursor = 0;
+  Snapshot::overrun = false;
+}
+
+
+/// @brief Starts reading from the first value
+void Snapshot::rewind()
+{
+  Snapshot::cursor = 0;
+  Snapshot::overrun = false;
+}
+
+
+/// @brief Reads from external memory instead of the buffer (until clear()).
+/// The memory must outlive the reads
+/// @param data
+/// @param bytes
+void Snapshot::attach(const void *data, size_t bytes)
+{
+  Snapshot::clear();
+  Snapshot::source = (const unsigned char *)data;
+  Snapshot::used = bytes;
+}
+
+
+/// @brief Appends raw bytes
+/// @param data
+/// @param bytes
+void Snapshot::write(const void *data, size_t bytes)
+{
+  if(Snapshot::used + bytes > Snapshot::buffer.size()) {
+    Snapshot::buffer.resize(std::max(Snapshot::used + bytes, 2 * Snapshot::buffer.size()));
+  }
+  if(bytes > 0) std::memcpy(Snapshot::buffer.data() + Snapshot::used, data, bytes);
+  Snapshot::used += bytes;
+}
+
+
+/// @brief Reads the next raw bytes (in the order they were written)
+/// @param data
+/// @param bytes
+/// @return false if the snapshot ends before them (data is left untouched)
+bool Snapshot::read(void *data, size_t bytes)
+{
+  if(bytes > Snapshot::remaining()) {
+    Snapshot::overrun = true;
+    Snapshot::cursor = Snapshot::used;
+    return false;
+  }
+
+  if(bytes > 0) std::memcpy(data, Snapshot::data() + Snapshot::cursor, bytes);
+  Snapshot::cursor += bytes;
+  return true;
+}
+
+
+/// @brief Moves the read cursor over bytes without copying them
+/// @param bytes
+void Snapshot::skip(size_t bytes)
+{
+  if(bytes > Snapshot::remaining()) {
+    Snapshot::overrun = true;
+    bytes = Snapshot::remaining();
+  }
+  Snapshot::cursor += bytes;
+}
+
+
+/// @brief Pads the written bytes to a multiple of alignment (the next value starts aligned)
+/// @param alignment at most 64
+void Snapshot::align_write(size_t alignment)
+{
+  static const unsigned char zeros[64] = {};
+  Snapshot::write(zeros, (alignment - Snapshot::used % alignment) % alignment);
+}
+
+
+/// @brief Skips the padding written by align_write()
+/// @param alignment
+void Snapshot::align_read(size_t alignment)
+{
+  Snapshot::skip((alignment - Snapshot::cursor % alignment) % alignment);
+}
+
+
+// Getters===========
+size_t Snapshot::size() const
+{
+  return Snapshot::used;
+}
+
+size_t Snapshot::remaining() const
+{
+  return Snapshot::used - Snapshot::cursor;
+}
+
+const unsigned char *Snapshot::data() const
+{
+  return Snapshot::source != nullptr ? Snapshot::source : Snapshot::buffer.data();
+}
+
+bool Snapshot::is_overrun() const
+{
+  return Snapshot::overrun;
+}
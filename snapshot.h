@@ -0,0 +1,78 @@
+#ifndef snapshot_h
+#define snapshot_h
+
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+
+/// @brief Contiguous byte buffer holding a copy of the world state.
+/// Values are appended with put() and read back in the same order with get();
+/// only trivially copyable types are accepted, so both are plain memory copies.
+/// The buffer keeps its storage between snapshots. A snapshot can also read
+/// memory it does not own (e.g. a mapped file), which is never copied as a whole
+class Snapshot {
+
+  // Private by default
+  std::vector<unsigned char> buffer = {};
+  const unsigned char *source = nullptr;  // attached memory (read only)
+  size_t used = 0;                         // bytes written
+  size_t cursor = 0;                       // next byte to read
+  bool overrun = false;                    // a read went past the end
+
+  public:
+    Snapshot(){}
+    void clear();
+    void rewind();
+    void attach(const void *data, size_t bytes);
+    void write(const void *data, size_t bytes);
+    bool read(void *data, size_t bytes);
+    void skip(size_t bytes);
+    void align_write(size_t alignment);
+    void align_read(size_t alignment);
+
+    template <typename T>
+    void put(const T &value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "snapshots only copy raw memory");
+      Snapshot::write(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void get(T &value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "snapshots only copy raw memory");
+      Snapshot::read(&value, sizeof(T));
+    }
+
+    // First count elements of a vector (resized to them on get)
+    template <typename T>
+    void put_vector(const std::vector<T> &values, size_t count)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "snapshots only copy raw memory");
+      Snapshot::put(count);
+      Snapshot::write(values.data(), count * sizeof(T));
+    }
+
+    template <typename T>
+    void get_vector(std::vector<T> &values)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "snapshots only copy raw memory");
+      size_t count = 0;
+      Snapshot::get(count);
+      if(count > Snapshot::remaining() / sizeof(T)) {
+        Snapshot::overrun = true;  // corrupted length
+        count = 0;
+      }
+      values.resize(count);
+      Snapshot::read(values.data(), count * sizeof(T));
+    }
+
+    // getters
+    size_t size() const;
+    size_t remaining() const;
+    const unsigned char *data() const;
+    bool is_overrun() const;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "../shot_pool.h"
+#include "../snapshot.h"
+#include <iostream>
+
+// Values written after the shots, as restore_world() reads the timers after them
+#define TEST_AFTER_DOUBLE 1234.5
+#define TEST_AFTER_INT    77
+
+static int failures = 0;
+
+//==========================================
+// Reports a failed expectation
+static void expect(bool condition, const char *what)
+{
+  if(condition) return;
+  std::cerr << "FAILED: " << what << std::endl;
+  failures++;
+}
+
+
+//==========================================
+// Snapshot of a pool holding count shots, followed by two more values
+static void save_pool(Snapshot &snapshot, size_t capacity, size_t count)
+{
+  ShotPool pool;
+  pool.setup(capacity);
+  for(size_t i = 0; i < count; i++) {
+    double point[2] = { (double)i, 2.0 * i };
+    double direction[2] = { 1, 0 };
+    pool.spawn(Shot(point, direction));
+  }
+
+  snapshot.clear();
+  pool.save(snapshot);
+  snapshot.put((double)TEST_AFTER_DOUBLE);
+  snapshot.put((int)TEST_AFTER_INT);
+  snapshot.rewind();
+}
+
+
+//==========================================
+// Reads the values after the shots
+static void expect_after(Snapshot &snapshot, const char *what)
+{
+  double after_double = 0;
+  int after_int = 0;
+  snapshot.get(after_double);
+  snapshot.get(after_int);
+  expect(after_double == TEST_AFTER_DOUBLE && after_int == TEST_AFTER_INT && !snapshot.is_overrun(), what);
+  expect(snapshot.remaining() == 0, what);
+}
+
+
+int main()
+{
+  Snapshot snapshot;
+
+  // Shots fitting the pool are restored
+  save_pool(snapshot, 8, 5);
+  ShotPool same;
+  same.setup(8);
+  expect(same.restore(snapshot), "restore into a pool of the same capacity");
+  expect(same.size() == 5, "restored shot count");
+  expect_after(snapshot, "fields after restored shots");
+
+  // Too many shots: the pool is left empty and the cursor is past the shots
+  save_pool(snapshot, 8, 5);
+  ShotPool small;
+  small.setup(2);
+  expect(!small.restore(snapshot), "restore of an oversized snapshot fails");
+  expect(small.size() == 0, "pool left empty");
+  expect_after(snapshot, "fields after oversized shots");
+
+  // The rejected pool still works
+  double point[2] = { 0, 0 };
+  double direction[2] = { 1, 0 };
+  expect(small.spawn(Shot(point, direction)) && small.size() == 1, "spawn after a failed restore");
+
+  if(failures > 0) return 1;
+  std::cout << "shot pool: all tests passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,177 @@
+#include "../rng.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+// Shapes in the units of assets/arena.svg
+#define PLAYER_RADIUS     4.7036037
+#define PLATFORM_HEIGHT   3.0238097
+#define PLATFORM_MIN      10.0   // platform widths
+#define PLATFORM_MAX      32.0
+#define STEP_SIZE         6.0    // blocks standing on the floor (low enough to jump over)
+#define START_CLEARANCE   40.0   // free floor around the player spawn
+#define ENEMIES_ON_FLOOR  0.5    // the others stand on platforms
+
+// Random streams of each feature (changing one parameter keeps the others)
+enum GeneratorStream {
+  ObstacleStream,
+  EnemyStream
+};
+
+// How platform heights above the floor are drawn
+enum HeightDistribution {
+  UniformHeights,
+  LowHeights,     // denser close to the floor
+  HighHeights,    // denser close to the ceiling
+  LayeredHeights  // a few fixed tiers
+};
+
+struct Obstacle {
+  double x;
+  double y;
+  double width;
+  double height;
+};
+
+
+//==========================================
+// Platform top in [lowest, highest] (y grows downward) following the distribution
+static double platform_y(HeightDistribution distribution, int layers, double lowest, double highest, RngStream &rng)
+{
+  double u = rng.next_uniform(0, 1);
+
+  switch(distribution) {
+    case LowHeights:
+      u = u * u;
+      break;
+    case HighHeights:
+      u = 1 - u * u;
+      break;
+    case LayeredHeights:
+      u = (layers > 1) ? (double)rng.next_below(layers) / (layers - 1) : 0;
+      break;
+    default:
+      break;
+  }
+  return lowest - u * (lowest - highest);
+}
+
+
+//=============================//
+// Arena generator             //
+//=============================//
+// Writes an arena in the svg dialect of the game (blue bounds, black obstacles,
+// green player, red enemies). Floor blocks (--steps, a fraction of the obstacles) must
+// be jumped over; without them the floor is walkable end to end.
+// The same parameters and seed give the same file:
+//   arenagen big.svg --width 100000 --obstacles 100000 --enemies 2000 --seed 1
+int main(int argc, char *argv[])
+{
+  if(argc < 2){
+    std::cerr << "Usage: " << argv[0] << " <arena.svg> [--width W] [--height H] [--density D | --obstacles N]" << std::endl;
+    std::cerr << "       [--heights uniform|low|high|layers] [--layers K] [--steps F] [--enemies N] [--seed S]" << std::endl;
+    return 1;
+  }
+
+  double width = 10000;
+  double height = 91.659218;
+  double density = 20;  // obstacles per 100 units of width
+  long obstacles = -1;  // overrides the density
+  HeightDistribution distribution = UniformHeights;
+  int layers = 3;
+  double steps = 0.2;   // fraction of obstacles that are floor blocks
+  long enemies = 100;
+  uint64_t seed = 1;
+
+  for(int i = 2; i < argc; i++){
+    if(!strcmp(argv[i], "--width") and i + 1 < argc) width = atof(argv[++i]);
+    else if(!strcmp(argv[i], "--height") and i + 1 < argc) height = atof(argv[++i]);
+    else if(!strcmp(argv[i], "--density") and i + 1 < argc) density = atof(argv[++i]);
+    else if(!strcmp(argv[i], "--obstacles") and i + 1 < argc) obstacles = atol(argv[++i]);
+    else if(!strcmp(argv[i], "--steps") and i + 1 < argc) steps = atof(argv[++i]);
+    else if(!strcmp(argv[i], "--layers") and i + 1 < argc) layers = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "--enemies") and i + 1 < argc) enemies = atol(argv[++i]);
+    else if(!strcmp(argv[i], "--seed") and i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+    else if(!strcmp(argv[i], "--heights") and i + 1 < argc){
+      i++;
+      if(!strcmp(argv[i], "uniform")) distribution = UniformHeights;
+      else if(!strcmp(argv[i], "low")) distribution = LowHeights;
+      else if(!strcmp(argv[i], "high")) distribution = HighHeights;
+      else if(!strcmp(argv[i], "layers")) distribution = LayeredHeights;
+      else {
+        std::cerr << "Unknown heights: " << argv[i] << " (uniform, low, high or layers)" << std::endl;
+        return 1;
+      }
+    }
+    else {
+      std::cerr << "Unknown option: " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  if(width <= 2 * START_CLEARANCE || height <= 4 * PLAYER_RADIUS){
+    std::cerr << "Arena too small" << std::endl;
+    return 1;
+  }
+  if(obstacles < 0) obstacles = (long)(density * width / 100);
+
+  Rng rng;
+  rng.set_seed(seed);
+  RngStream obstacle_rng(rng, GeneratorStream::ObstacleStream);
+  RngStream enemy_rng(rng, GeneratorStream::EnemyStream);
+
+  // Obstacles (the arena spans [0, width] x [0, height], floor at y = height)===========
+  double lowest = height - 3 * PLAYER_RADIUS;   // room to walk below platforms
+  double highest = 2 * PLAYER_RADIUS;
+  std::vector<Obstacle> generated;
+  std::vector<size_t> platforms;
+  generated.reserve(obstacles);
+
+  for(long i = 0; i < obstacles; i++){
+    if(obstacle_rng.next_uniform(0, 1) < steps){
+      double x = obstacle_rng.next_uniform(START_CLEARANCE, width - STEP_SIZE);
+      generated.push_back({ x, height - STEP_SIZE, STEP_SIZE, STEP_SIZE });
+      continue;
+    }
+    double w = obstacle_rng.next_uniform(PLATFORM_MIN, PLATFORM_MAX);
+    double x = obstacle_rng.next_uniform(0, width - w);
+    double y = platform_y(distribution, layers, lowest, highest, obstacle_rng);
+    platforms.push_back(generated.size());
+    generated.push_back({ x, y, w, PLATFORM_HEIGHT });
+  }
+
+  FILE *file = fopen(argv[1], "w");
+  if(file == nullptr){
+    std::cerr << "Could not write " << argv[1] << std::endl;
+    return 1;
+  }
+
+  fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n");
+  fprintf(file, "  <rect x=\"0\" y=\"0\" width=\"%.4f\" height=\"%.6f\" fill=\"blue\" />\n", width, height);
+  for(const Obstacle &o: generated){
+    fprintf(file, "  <rect x=\"%.4f\" y=\"%.4f\" width=\"%.4f\" height=\"%.7f\" fill=\"black\" />\n", o.x, o.y, o.width, o.height);
+  }
+
+  // Players (standing, the floor is the arena bottom)=============
+  double floor_cy = height - PLAYER_RADIUS - 0.05;
+  fprintf(file, "  <circle cx=\"%.4f\" cy=\"%.4f\" r=\"%.7f\" fill=\"green\" />\n", START_CLEARANCE / 2, floor_cy, PLAYER_RADIUS);
+
+  for(long i = 0; i < enemies; i++){
+    double cx, cy;
+    if(platforms.empty() || enemy_rng.next_uniform(0, 1) < ENEMIES_ON_FLOOR){
+      cx = enemy_rng.next_uniform(2 * START_CLEARANCE, width - PLAYER_RADIUS);
+      cy = floor_cy;
+    } else {
+      const Obstacle &p = generated[platforms[enemy_rng.next_below(platforms.size())]];
+      cx = p.x + p.width / 2;
+      cy = p.y - PLAYER_RADIUS - 0.05;
+    }
+    fprintf(file, "  <circle cx=\"%.4f\" cy=\"%.4f\" r=\"%.7f\" fill=\"red\" />\n", cx, cy, PLAYER_RADIUS);
+  }
+
+  fprintf(file, "</svg>\n");
+  return fclose(file) == 0 ? 0 : 1;
+}
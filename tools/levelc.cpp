@@ -0,0 +1,31 @@
+#include "../level.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+
+//=============================//
+// Level compiler              //
+//=============================//
+// Turns an svg arena into a compiled level the game maps at startup:
+//   levelc assets/arena.svg assets/arena.lvl
+// Very wide arenas can be cut in chunks the game streams around the camera:
+//   levelc wide.svg wide.lvl --chunk 400
+int main(int argc, char *argv[])
+{
+  double chunk_width = 0;
+
+  if(argc == 5 && !strcmp(argv[3], "--chunk")){
+    chunk_width = atof(argv[4]);
+  }
+  else if(argc != 3){
+    std::cerr << "Usage: " << argv[0] << " <arena.svg> <level" << LEVEL_EXTENSION << "> [--chunk width]" << std::endl;
+    return 1;
+  }
+
+  if(!Level::compile(argv[1], argv[2], chunk_width)){
+    std::cerr << "Could not compile " << argv[1] << " into " << argv[2] << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include "../utils.h"
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <sys/resource.h>
+
+#define SVGBENCH_RUNS 5
+
+
+//==========================================
+// Peak resident memory of the process (MiB)
+static double peak_memory()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+
+//==========================================
+// Best time of a reader over a few runs (ms)
+template <typename Reader>
+static double time_reader(Reader reader, std::vector<svg_tools::Rect> &r, std::vector<svg_tools::Circ> &c)
+{
+  double best = 0;
+
+  for(int run = 0; run < SVGBENCH_RUNS; run++) {
+    r.clear();
+    c.clear();
+    auto start = std::chrono::steady_clock::now();
+    reader();
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if(run == 0 || elapsed < best) best = elapsed;
+  }
+  return best;
+}
+
+
+//=============================//
+// Svg readers benchmark       //
+//=============================//
+// Times the streaming reader against the document reader on a file and checks
+// both read the same shapes. The streaming reader runs first so the peak memory
+// printed after it is its own:
+//   svgbench assets/arena.svg
+int main(int argc, char *argv[])
+{
+  if(argc != 2){
+    std::cerr << "Usage: " << argv[0] << " <arena.svg>" << std::endl;
+    return 1;
+  }
+
+  std::vector<svg_tools::Rect> stream_r, dom_r;
+  std::vector<svg_tools::Circ> stream_c, dom_c;
+  double base_memory = peak_memory();
+
+  bool ok = true;
+  double stream_ms = time_reader([&]() { ok = svg_tools::streamSvg(argv[1], stream_r, stream_c) && ok; }, stream_r, stream_c);
+  if(!ok){
+    std::cerr << "Could not stream " << argv[1] << std::endl;
+    return 1;
+  }
+  double stream_memory = peak_memory();
+
+  double dom_ms = time_reader([&]() { svg_tools::readSvg(argv[1], dom_r, dom_c); }, dom_r, dom_c);
+  double dom_memory = peak_memory();
+
+  // Same shapes, in the same order
+  bool same = stream_r.size() == dom_r.size() && stream_c.size() == dom_c.size();
+  for(size_t i = 0; same && i < dom_r.size(); i++) {
+    const svg_tools::Rect &a = stream_r[i], &b = dom_r[i];
+    same = a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height && a.color == b.color;
+  }
+  for(size_t i = 0; same && i < dom_c.size(); i++) {
+    const svg_tools::Circ &a = stream_c[i], &b = dom_c[i];
+    same = a.cx == b.cx && a.cy == b.cy && a.r == b.r && a.color == b.color;
+  }
+
+  std::cout << "shapes: " << dom_r.size() << " rects, " << dom_c.size() << " circles" << std::endl;
+  std::cout << "stream: " << stream_ms << " ms (peak memory +" << stream_memory - base_memory << " MiB)" << std::endl;
+  std::cout << "dom: " << dom_ms << " ms (peak memory +" << dom_memory - stream_memory << " MiB)" << std::endl;
+  std::cout << "speedup: " << (stream_ms > 0 ? dom_ms / stream_ms : 0) << "x" << std::endl;
+  std::cout << "match: " << (same ? "yes" : "NO") << std::endl;
+  return same ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "trace.h"
+#include "job_system.h"
+#include <cstdio>
+#include <algorithm>
+
+
+//==========================================
+// Json string (names are plain text, only quotes and backslashes are escaped)
+static void write_string(FILE *file, const char *text)
+{
+  fputc('"', file);
+  for(; *text; text++) {
+    if(*text == '"' || *text == '\\') fputc('\\', file);
+    fputc(*text, file);
+  }
+  fputc('"', file);
+}
+
+
+/// @brief Allocates the rings and forgets the recorded events
+/// @param capacity events kept per thread, 0 disables the log
+/// @param threads job system threads (main thread included)
+void TraceLog::setup(size_t capacity, unsigned threads)
+{
+  TraceLog::rings.clear();
+  for(unsigned t = 0; capacity > 0 && t < threads; t++) {
+    TraceLog::rings.push_back(std::make_unique<Ring>());
+    TraceLog::rings.back()->events.assign(capacity, {});
+  }
+  TraceLog::start = std::chrono::steady_clock::now();
+}
+
+
+/// @brief Records an event of the calling thread (any job system thread, overwrites
+/// the oldest event of that thread)
+/// @param name
+/// @param category
+/// @param begin
+/// @param end
+void TraceLog::record(
+  const char *name, const char *category,
+  std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end
+)
+{
+  unsigned thread = JobSystem::get_current_thread();
+  if(thread >= TraceLog::rings.size()) return;
+
+  // Single writer: the slot is filled before the count publishes it
+  Ring &ring = *TraceLog::rings[thread];
+  uint64_t n = ring.recorded.load(std::memory_order_relaxed);
+  TraceEvent &e = ring.events[n % ring.events.size()];
+  e.name = name;
+  e.category = category;
+  e.begin = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - TraceLog::start).count();
+  e.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  e.tick = TraceLog::tick.load(std::memory_order_relaxed);
+  e.thread = thread;
+  ring.recorded.store(n + 1, std::memory_order_release);
+}
+
+
+/// @brief Writes the kept events of every thread, merged oldest first, as trace-event json
+/// (must not run while events are recorded)
+/// @param path
+/// @param threads names the main thread and the workers
+/// @return false if the file could not be written
+bool TraceLog::save(const char *path, unsigned threads) const
+{
+  FILE *file = fopen(path, "w");
+  if(file == nullptr) return false;
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for(unsigned t = 0; t < threads; t++) {
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", t);
+    if(t == 0) {
+      fprintf(file, "\"main\"}},\n");
+    } else {
+      fprintf(file, "\"worker %u\"}},\n", t);
+    }
+  }
+
+  std::vector<const TraceEvent *> kept;
+  kept.reserve(TraceLog::size());
+  for(const std::unique_ptr<Ring> &ring: TraceLog::rings) {
+    uint64_t recorded = ring->recorded.load(std::memory_order_acquire);
+    uint64_t first = recorded - std::min<uint64_t>(recorded, ring->events.size());
+    for(uint64_t i = first; i < recorded; i++) {
+      kept.push_back(&ring->events[i % ring->events.size()]);
+    }
+  }
+  std::stable_sort(kept.begin(), kept.end(), [](const TraceEvent *e1, const TraceEvent *e2) {
+    return e1->begin < e2->begin;
+  });
+
+  for(const TraceEvent *event: kept) {
+    const TraceEvent &e = *event;
+    fprintf(file, "{\"name\":");
+    write_string(file, e.name);
+    fprintf(file, ",\"cat\":");
+    write_string(file, e.category);
+    fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"tick\":%u}},\n",
+      e.begin / 1000.0, e.duration / 1000.0, e.thread, e.tick);
+  }
+
+  // Metadata closes the list (no trailing comma)
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"trabalhocg (%llu events dropped)\"}}\n]}\n",
+    (unsigned long long)TraceLog::get_dropped());
+
+  bool ok = !ferror(file);
+  return fclose(file) == 0 && ok;
+}
+
+
+// Getters===========
+bool TraceLog::is_enabled() const
+{
+  return !TraceLog::rings.empty();
+}
+
+size_t TraceLog::size() const
+{
+  size_t kept = 0;
+  for(const std::unique_ptr<Ring> &ring: TraceLog::rings) {
+    kept += std::min<uint64_t>(ring->recorded.load(std::memory_order_acquire), ring->events.size());
+  }
+  return kept;
+}
+
+uint64_t TraceLog::get_dropped() const
+{
+  uint64_t recorded = 0;
+  for(const std::unique_ptr<Ring> &ring: TraceLog::rings) {
+    recorded += ring->recorded.load(std::memory_order_acquire);
+  }
+  return recorded - TraceLog::size();
+}
+
+
+// Setters===========
+void TraceLog::set_tick(uint32_t tick)
+{
+  TraceLog::tick.store(tick, std::memory_order_relaxed);
+}
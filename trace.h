@@ -0,0 +1,59 @@
+#ifndef trace_h
+#define trace_h
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// Default number of events kept per thread (the newest ones)
+#define TRACE_CAPACITY 65536
+
+/// @brief Timed event of a thread
+struct TraceEvent {
+  const char *name;      // must outlive the log (e.g. literals or stage names)
+  const char *category;
+  int64_t begin;         // ns since the log started
+  int64_t duration;      // ns
+  uint32_t tick;         // simulation tick running when the event ended
+  uint32_t thread;       // job system thread (0 is the main thread)
+};
+
+/// @brief Ring buffers of the latest timed events, written as a Chrome trace-event file
+/// (chrome://tracing, Perfetto). Each job system thread records into its own ring, so
+/// recording is lock free, never allocates and never shares a slot between threads; the log
+/// can stay on for whole sessions: only the last `capacity` events of each thread are kept
+class TraceLog {
+
+  // Events of one thread (only that thread writes them)
+  struct Ring {
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> recorded{0};  // events ever recorded
+  };
+
+  // Private by default
+  std::vector<std::unique_ptr<Ring>> rings = {};  // one per job system thread
+  std::atomic<uint32_t> tick{0};
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  public:
+    TraceLog(){}
+    void setup(size_t capacity, unsigned threads);
+    void record(
+      const char *name, const char *category,
+      std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end
+    );
+    bool save(const char *path, unsigned threads) const;
+
+    // getters
+    bool is_enabled() const;
+    size_t size() const;
+    uint64_t get_dropped() const;
+
+    // setters
+    void set_tick(uint32_t tick);
+};
+
+#endif
@@ -1,6 +1,13 @@
 #include "utils.h"
 #include <math.h>
 #include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 namespace svg_tools {
   
@@ -41,6 +48,181 @@ namespace svg_tools {
       circ = circ->NextSiblingElement("circle");
     }
   }
+
+
+  //==================================================
+  // Streaming reader helpers (tags are [begin, end) views of the read buffer)
+
+  // Value of an attribute of a tag, empty if it is missing
+  static std::string_view attribute(const char *begin, const char *end, std::string_view name)
+  {
+    const char *p = begin;
+
+    while(p < end) {
+      // Attribute name
+      while(p < end && (isspace((unsigned char)*p) || *p == '/')) p++;
+      const char *name_begin = p;
+      while(p < end && *p != '=' && !isspace((unsigned char)*p)) p++;
+      std::string_view found(name_begin, p - name_begin);
+
+      // Quoted value
+      while(p < end && *p != '"' && *p != '\'') p++;
+      if(p >= end) break;
+      char quote = *p++;
+      const char *value_begin = p;
+      while(p < end && *p != quote) p++;
+      if(found == name) return std::string_view(value_begin, p - value_begin);
+      p++;
+    }
+    return {};
+  }
+
+  // Number like std::stod reads it (leading blanks and sign allowed), 0 if malformed
+  static double number(std::string_view text)
+  {
+    const char *p = text.data(), *end = p + text.size();
+    while(p < end && isspace((unsigned char)*p)) p++;
+    if(p < end && *p == '+') p++;
+
+    double value = 0;
+    std::from_chars(p, end, value);
+    return value;
+  }
+
+  // Emits the tag if it is a rect or a circle
+  static void element(const char *begin, const char *end, std::vector<Rect> &r, std::vector<Circ> &c)
+  {
+    size_t length = end - begin;
+
+    if(length >= 4 && !memcmp(begin, "rect", 4) && (length == 4 || !isalnum((unsigned char)begin[4]))) {
+      r.push_back({
+        number(attribute(begin + 4, end, "x")),
+        number(attribute(begin + 4, end, "y")),
+        number(attribute(begin + 4, end, "width")),
+        number(attribute(begin + 4, end, "height")),
+        std::string(attribute(begin + 4, end, "fill"))
+      });
+    }
+    else if(length >= 6 && !memcmp(begin, "circle", 6) && (length == 6 || !isalnum((unsigned char)begin[6]))) {
+      c.push_back({
+        number(attribute(begin + 6, end, "cx")),
+        number(attribute(begin + 6, end, "cy")),
+        number(attribute(begin + 6, end, "r")),
+        std::string(attribute(begin + 6, end, "fill"))
+      });
+    }
+  }
+
+  // End of the markup starting at p ('<' excluded), nullptr if it is not all in [p, end)
+  static const char *markup_end(const char *p, const char *end)
+  {
+    const char *closing = nullptr;
+
+    if(end - p >= 3 && !memcmp(p, "!--", 3)) {
+      closing = std::search(p + 3, end, "-->", "-->" + 3);
+      return closing == end ? nullptr : closing + 3;
+    }
+    if(end - p >= 8 && !memcmp(p, "![CDATA[", 8)) {
+      closing = std::search(p + 8, end, "]]>", "]]>" + 3);
+      return closing == end ? nullptr : closing + 3;
+    }
+
+    // Tags end at the first '>' outside quotes
+    char quote = 0;
+    for(; p < end; p++) {
+      if(quote) { if(*p == quote) quote = 0; }
+      else if(*p == '"' || *p == '\'') quote = *p;
+      else if(*p == '>') return p + 1;
+    }
+    return nullptr;
+  }
+
+
+  /// @brief Reads a .svg file like readSvg() without building a document:
+  /// the file is tokenized through a fixed buffer and rect/circle children of the
+  /// root svg element are emitted as they are found (memory does not grow with the file)
+  /// @param file 
+  /// @param r 
+  /// @param c 
+  /// @return false if the file cannot be read, is truncated or has a tag longer than the buffer
+  bool streamSvg(char * file, std::vector<Rect> &r, std::vector<Circ> &c)
+  {
+    int fd = open(file, O_RDONLY);
+    if(fd < 0) return false;
+
+    std::vector<char> buffer(SVG_STREAM_BUFFER);
+    size_t filled = 0;    // bytes in the buffer
+    size_t cursor = 0;    // first byte not consumed yet
+    int depth = 0;        // open elements (the root svg is depth 1)
+    bool root_done = false;
+    bool ok = true;
+
+    while(ok) {
+      // Keeping the unconsumed bytes and reading more after them
+      memmove(buffer.data(), buffer.data() + cursor, filled - cursor);
+      filled -= cursor;
+      cursor = 0;
+
+      ssize_t got = read(fd, buffer.data() + filled, buffer.size() - filled);
+      if(got < 0) ok = false;
+      if(got <= 0) break;
+      filled += got;
+
+      const char *begin = buffer.data(), *end = begin + filled;
+
+      while(true) {
+        const char *markup = (const char *)memchr(begin + cursor, '<', filled - cursor);
+        if(markup == nullptr) {
+          cursor = filled;  // text between tags
+          break;
+        }
+        const char *markup_stop = markup_end(markup + 1, end);
+        if(markup_stop == nullptr) {
+          cursor = markup - begin;  // incomplete, read more
+          if(cursor == 0 && filled == buffer.size()) ok = false;  // longer than the buffer
+          break;
+        }
+        cursor = markup_stop - begin;
+
+        const char *tag = markup + 1, *tag_end = markup_stop - 1;
+        if(*tag == '?' || *tag == '!' || root_done) continue;
+
+        // Closing tag
+        if(*tag == '/') {
+          if(--depth == 0) root_done = true;  // only the first root counts, like readSvg()
+          continue;
+        }
+
+        bool self_closing = tag_end > tag && tag_end[-1] == '/';
+        if(depth == 1) element(tag, tag_end, r, c);
+
+        if(!self_closing) depth++;
+        else if(depth == 0) root_done = true;
+      }
+    }
+
+    close(fd);
+    return ok && root_done;
+  }
+
+
+  /// @brief Reads a .svg file with the reader that suits its size
+  /// (documents for usual levels, streaming for huge ones)
+  /// @param file 
+  /// @param r 
+  /// @param c 
+  /// @return false if the file cannot be read
+  bool loadSvg(char * file, std::vector<Rect> &r, std::vector<Circ> &c)
+  {
+    struct stat info;
+    if(stat(file, &info) != 0) return false;
+
+    if(info.st_size >= SVG_STREAM_MIN_BYTES) {
+      return streamSvg(file, r, c);
+    }
+    readSvg(file, r, c);
+    return true;
+  }
 }
 
 
@@ -62,3 +244,50 @@ namespace matrix_tools {
     point[1] = (sin(angleRad) * x) + (cos(angleRad) * y);
   }
 }
+
+
+namespace geometry_tools {
+  /// @brief Segment (x0,y0)->(x0+dx,y0+dy) against an AABB (slab test)
+  /// @param t_max farthest segment parameter accepted
+  /// @param t entry parameter of the segment into the box
+  /// @return true if they intersect within [0, t_max]
+  bool segment_hits_box(
+    double x0, double y0, double dx, double dy,
+    double min_x, double min_y, double max_x, double max_y,
+    double t_max, double &t)
+  {
+    double t_enter = 0;
+    double t_exit = t_max;
+
+    // X slab
+    if(dx == 0) {
+      if(x0 < min_x || x0 > max_x) return false;
+    } else {
+      double t1 = (min_x - x0) / dx;
+      double t2 = (max_x - x0) / dx;
+      t_enter = std::max(t_enter, std::min(t1, t2));
+      t_exit = std::min(t_exit, std::max(t1, t2));
+    }
+
+    // Y slab
+    if(dy == 0) {
+      if(y0 < min_y || y0 > max_y) return false;
+    } else {
+      double t1 = (min_y - y0) / dy;
+      double t2 = (max_y - y0) / dy;
+      t_enter = std::max(t_enter, std::min(t1, t2));
+      t_exit = std::min(t_exit, std::max(t1, t2));
+    }
+
+    if(t_enter > t_exit) return false;
+    t = t_enter;
+    return true;
+  }
+
+
+  /// @brief Closed overlap of a rectangle and an AABB (touching counts, like the slab test)
+  bool rect_overlaps_box(const svg_tools::Rect &r, double min_x, double min_y, double max_x, double max_y)
+  {
+    return r.x <= max_x && min_x <= r.x + r.width && r.y <= max_y && min_y <= r.y + r.height;
+  }
+}
@@ -12,6 +12,10 @@
 #define BLUE { 0.0, 0.0, 1.0 }
 #define YELLOW { 1.0, 1.0, 0 }
 
+// Streaming svg reader
+#define SVG_STREAM_BUFFER    (64 * 1024)  // bytes read at once, also the longest tag accepted
+#define SVG_STREAM_MIN_BYTES (4 << 20)    // loadSvg() streams files from this size on
+
 enum JumpState {
   NotJumping,
   Jumping
@@ -51,6 +55,8 @@ namespace svg_tools {
   };
 
   void readSvg(char * file, std::vector<Rect> &r, std::vector<Circ> &c);
+  bool streamSvg(char * file, std::vector<Rect> &r, std::vector<Circ> &c);
+  bool loadSvg(char * file, std::vector<Rect> &r, std::vector<Circ> &c);
 }
 
 // Transformer matrix operations
@@ -59,4 +65,14 @@ namespace matrix_tools {
   void rotatePoint2d(double point[2], double angle);
 }
 
+// Intersection tests
+namespace geometry_tools {
+  bool segment_hits_box(
+    double x0, double y0, double dx, double dy,
+    double min_x, double min_y, double max_x, double max_y,
+    double t_max, double &t
+  );
+  bool rect_overlaps_box(const svg_tools::Rect &r, double min_x, double min_y, double max_x, double max_y);
+}
+
 #endif